@@ -0,0 +1,192 @@
+/*
+  This program is free software; you can redistribute it and/or
+  modify it under the terms of the GNU General Public License as
+  published by the Free Software Foundation; either version 2 of
+  the License or (at your option) version 3 or any later version
+  accepted by the membership of KDE e.V. (or its successor appro-
+  ved by the membership of KDE e.V.), which shall act as a proxy
+  defined in Section 14 of version 3 of the license.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program. If not, see http://www.gnu.org/licenses/.
+*/
+
+
+
+// Skin application benchmark.
+//
+// Creates a MainWindow on the offscreen platform plugin in a scratch home
+// directory and times MainWindow::applySkin(), including the event processing
+// it causes. For comparison it also times applying the stylesheets the skin
+// buttons used to be drawn with to the same six buttons. Results are printed
+// to stdout as a JSON object:
+//
+//   iterations             number of timed runs of each case
+//   apply_skin_ms          mean time of one MainWindow::applySkin()
+//   stylesheet_buttons_ms  mean time of restyling the buttons through QSS
+
+
+#include "mainwindow.h"
+#include "settings.h"
+
+#include <QApplication>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QFileInfo>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QList>
+#include <QPair>
+#include <QPixmap>
+#include <QPushButton>
+#include <QStandardPaths>
+#include <QTemporaryDir>
+#include <QToolButton>
+
+#include <cstdio>
+#include <cstdlib>
+
+
+static const int defaultIterations = 100;
+
+
+static double toMilliseconds(qint64 nsecs)
+{
+    return nsecs / 1000000.0;
+}
+
+static QString buttonStyleSheet(const QString& up, const QString& over, const QString& down)
+{
+    QPixmap buttonImage(up);
+    QString w(QString::number(buttonImage.width()));
+    QString h(QString::number(buttonImage.height()));
+
+    QString sizeBit(QStringLiteral("min-width:") + w + QStringLiteral("; min-height:") + h
+        + QStringLiteral("; max-width:") + w + QStringLiteral("; max-height:") + h + QStringLiteral(";"));
+
+    QString styleSheet;
+
+    foreach (const QString& widget, QStringList() << QStringLiteral("QPushButton") << QStringLiteral("QToolButton"))
+    {
+        styleSheet.append(widget + QStringLiteral(" {border: none; image:url(") + up + QStringLiteral(");") + sizeBit + QStringLiteral("}"));
+        styleSheet.append(widget + QStringLiteral("::hover {border: none; image:url(") + over + QStringLiteral(");") + sizeBit + QStringLiteral("}"));
+
+        foreach (const QString& state, QStringList() << QStringLiteral("pressed") << QStringLiteral("checked") << QStringLiteral("open"))
+            styleSheet.append(widget + QStringLiteral("::") + state + QStringLiteral(" {border: none; image:url(") + down + QStringLiteral(");") + sizeBit + QStringLiteral("}"));
+
+        styleSheet.append(widget + QStringLiteral("::menu-indicator { left: ") + w + QStringLiteral(" }"));
+    }
+
+    return styleSheet;
+}
+
+int main(int argc, char* argv[])
+{
+    QTemporaryDir home;
+
+    if (!home.isValid())
+    {
+        fprintf(stderr, "could not create a scratch home directory\n");
+
+        return 1;
+    }
+
+    QDir(home.path()).mkpath(QStringLiteral(".config"));
+
+    qputenv("HOME", QFile::encodeName(home.path()));
+    qputenv("XDG_CONFIG_HOME", QFile::encodeName(home.path() + QStringLiteral("/.config")));
+    qputenv("XDG_CACHE_HOME", QFile::encodeName(home.path() + QStringLiteral("/.cache")));
+    qputenv("XDG_DATA_HOME", QFile::encodeName(home.path() + QStringLiteral("/.local/share")));
+
+    if (qgetenv("QT_QPA_PLATFORM").isEmpty())
+        qputenv("QT_QPA_PLATFORM", "offscreen");
+
+    QApplication app(argc, argv);
+    app.setQuitOnLastWindowClosed(false);
+    app.setApplicationName(QStringLiteral("yakuake"));
+    app.setOrganizationDomain(QStringLiteral("kde.org"));
+
+    int iterations = argc > 1 ? atoi(argv[1]) : defaultIterations;
+
+    if (iterations <= 0) iterations = defaultIterations;
+
+    Settings::setFirstRun(false);
+
+    MainWindow mainWindow;
+    mainWindow.show();
+    app.processEvents();
+
+    QElapsedTimer clock;
+    clock.start();
+
+    for (int iteration = 0; iteration < iterations; ++iteration)
+    {
+        QMetaObject::invokeMethod(&mainWindow, "applySkin");
+        app.processEvents();
+    }
+
+    qint64 applySkin = clock.nsecsElapsed();
+
+    // The title bar and tab bar buttons of the default skin, styled the old way.
+    QString skinDir = QFileInfo(QStandardPaths::locate(QStandardPaths::DataLocation,
+        QStringLiteral("skins/default/title.skin"))).absolutePath();
+
+    QWidget buttonParent;
+    QList<QPair<QAbstractButton*, QString> > buttons;
+
+    QStringList titleButtons = QStringList() << QStringLiteral("focus") << QStringLiteral("config") << QStringLiteral("quit");
+
+    foreach (const QString& name, titleButtons)
+    {
+        QString prefix = skinDir + QStringLiteral("/title/") + name;
+        QString over = (name == QStringLiteral("focus")) ? QStringLiteral("_over.png") : QStringLiteral("_down.png");
+
+        buttons << qMakePair(static_cast<QAbstractButton*>(new QPushButton(&buttonParent)),
+            buttonStyleSheet(prefix + QStringLiteral("_up.png"), prefix + over, prefix + QStringLiteral("_down.png")));
+    }
+
+    // New tab and new group were tool buttons, the close buttons push buttons.
+    QString prefix = skinDir + QStringLiteral("/tabs/add");
+    QString styleSheet = buttonStyleSheet(prefix + QStringLiteral("_up.png"), prefix + QStringLiteral("_down.png"),
+        prefix + QStringLiteral("_down.png"));
+
+    buttons << qMakePair(static_cast<QAbstractButton*>(new QToolButton(&buttonParent)), styleSheet);
+    buttons << qMakePair(static_cast<QAbstractButton*>(new QToolButton(&buttonParent)), styleSheet);
+
+    prefix = skinDir + QStringLiteral("/tabs/close");
+    styleSheet = buttonStyleSheet(prefix + QStringLiteral("_up.png"), prefix + QStringLiteral("_down.png"),
+        prefix + QStringLiteral("_down.png"));
+
+    buttons << qMakePair(static_cast<QAbstractButton*>(new QPushButton(&buttonParent)), styleSheet);
+    buttons << qMakePair(static_cast<QAbstractButton*>(new QPushButton(&buttonParent)), styleSheet);
+
+    buttonParent.show();
+    app.processEvents();
+
+    clock.restart();
+
+    for (int iteration = 0; iteration < iterations; ++iteration)
+    {
+        for (int index = 0; index < buttons.count(); ++index)
+            buttons.at(index).first->setStyleSheet(buttons.at(index).second);
+
+        app.processEvents();
+    }
+
+    qint64 styleSheets = clock.nsecsElapsed();
+
+    QJsonObject result;
+    result.insert(QStringLiteral("iterations"), iterations);
+    result.insert(QStringLiteral("apply_skin_ms"), toMilliseconds(applySkin) / iterations);
+    result.insert(QStringLiteral("stylesheet_buttons_ms"), toMilliseconds(styleSheets) / iterations);
+
+    fprintf(stdout, "%s", QJsonDocument(result).toJson().constData());
+
+    return 0;
+}
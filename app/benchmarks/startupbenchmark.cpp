@@ -0,0 +1,273 @@
+/*
+  This program is free software; you can redistribute it and/or
+  modify it under the terms of the GNU General Public License as
+  published by the Free Software Foundation; either version 2 of
+  the License or (at your option) version 3 or any later version
+  accepted by the membership of KDE e.V. (or its successor appro-
+  ved by the membership of KDE e.V.), which shall act as a proxy
+  defined in Section 14 of version 3 of the license.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program. If not, see http://www.gnu.org/licenses/.
+*/
+
+
+
+// Headless startup benchmark.
+//
+// Without arguments, the benchmark generates layout files with 1, 10, 100 and
+// 500 tabs (ten tabs per group) and starts itself once per layout in a scratch
+// home directory, using the offscreen platform plugin. Other tab counts can be
+// passed as arguments. Each run creates a MainWindow the way main() does and
+// reports one JSON object; the collected results are printed to stdout as a
+// JSON array:
+//
+//   tabs                   number of tabs in the layout
+//   first_paint_ms         time from process start to the first paint event
+//   construct_ms           time from process start until MainWindow returned
+//   sessions_ready_ms      time until every session exists and is started
+//   peak_rss_kb            peak resident set size of the run
+//   konsolepart_instances  number of konsoleparts backing the restored sessions
+//   spare_konsolepart_instances  idle konsoleparts started by the terminal pool
+//   startup_timeline       the phases recorded by Metrics, one per line
+
+
+#include "mainwindow.h"
+#include "metrics.h"
+#include "sessionstack.h"
+#include "settings.h"
+
+#include <QApplication>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QProcess>
+#include <QTemporaryDir>
+#include <QTextStream>
+#include <QTimer>
+
+#include <cstdio>
+#include <cstdlib>
+
+#include <sys/resource.h>
+
+
+static const int tabsPerGroup = 10;
+static const int runTimeout = 600000;
+
+
+class FirstPaintFilter : public QObject
+{
+    public:
+        explicit FirstPaintFilter(const QElapsedTimer& clock) : m_clock(clock), m_painted(-1) {}
+
+        qint64 painted() { return m_painted; }
+
+        virtual bool eventFilter(QObject* object, QEvent* event)
+        {
+            if (m_painted < 0 && event->type() == QEvent::Paint)
+                m_painted = m_clock.nsecsElapsed();
+
+            return QObject::eventFilter(object, event);
+        }
+
+
+    private:
+        const QElapsedTimer& m_clock;
+        qint64 m_painted;
+};
+
+
+static double toMilliseconds(qint64 nsecs)
+{
+    return nsecs / 1000000.0;
+}
+
+static bool writeLayout(const QString& path, int tabs)
+{
+    QFile file(path);
+
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate))
+        return false;
+
+    QTextStream out(&file);
+
+    for (int tab = 0; tab < tabs; ++tab)
+    {
+        if (tab % tabsPerGroup == 0)
+        {
+            if (tab) out << "}\n\n";
+
+            out << "group g" << tab / tabsPerGroup << " {\n";
+
+            if (tab == 0) out << "    selected = true\n";
+        }
+
+        out << "    tab t" << tab << " {}\n";
+    }
+
+    if (tabs) out << "}\n";
+
+    return true;
+}
+
+static int runStartup(int argc, char* argv[], int tabs, const QElapsedTimer& clock)
+{
+    QApplication app(argc, argv);
+    app.setQuitOnLastWindowClosed(false);
+    app.setApplicationName(QStringLiteral("yakuake"));
+    app.setOrganizationDomain(QStringLiteral("kde.org"));
+
+    Metrics::self()->startStartupTimeline(clock);
+
+    Settings::setFirstRun(false);
+
+    FirstPaintFilter filter(clock);
+    app.installEventFilter(&filter);
+
+    MainWindow mainWindow;
+    qint64 constructed = clock.nsecsElapsed();
+
+    mainWindow.show();
+    Metrics::self()->finishStartupTimeline();
+
+    SessionStack* sessionStack = mainWindow.sessionStack();
+    qint64 sessionsReady = -1;
+
+    // Sessions outside the selected group are started from the event loop, so poll until all of them are.
+    QTimer poll;
+    poll.setInterval(5);
+
+    QObject::connect(&poll, &QTimer::timeout, [&]()
+    {
+        if (filter.painted() < 0) return;
+
+        QStringList sessionIds = sessionStack->sessionIdList().split(QLatin1Char(','), QString::SkipEmptyParts);
+
+        if (sessionIds.count() < tabs) return;
+
+        foreach (const QString& sessionId, sessionIds)
+            if (!sessionStack->isSessionRealized(sessionId.toInt())) return;
+
+        sessionsReady = clock.nsecsElapsed();
+        app.quit();
+    });
+
+    poll.start();
+    app.exec();
+
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+
+    QJsonObject result;
+    result.insert(QStringLiteral("tabs"), tabs);
+    result.insert(QStringLiteral("first_paint_ms"), toMilliseconds(filter.painted()));
+    result.insert(QStringLiteral("construct_ms"), toMilliseconds(constructed));
+    result.insert(QStringLiteral("sessions_ready_ms"), toMilliseconds(sessionsReady));
+    result.insert(QStringLiteral("peak_rss_kb"), double(usage.ru_maxrss));
+    result.insert(QStringLiteral("konsolepart_instances"), Metrics::self()->partCount());
+    result.insert(QStringLiteral("spare_konsolepart_instances"), Metrics::self()->sparePartCount());
+    result.insert(QStringLiteral("startup_timeline"), Metrics::self()->startupTimeline());
+
+    fprintf(stdout, "%s\n", QJsonDocument(result).toJson(QJsonDocument::Compact).constData());
+
+    return 0;
+}
+
+static int runBenchmark(int argc, char* argv[])
+{
+    QCoreApplication app(argc, argv);
+
+    QList<int> sizes;
+
+    foreach (const QString& argument, app.arguments().mid(1))
+    {
+        bool ok = false;
+        int tabs = argument.toInt(&ok);
+
+        if (ok && tabs > 0) sizes << tabs;
+    }
+
+    if (sizes.isEmpty()) sizes << 1 << 10 << 100 << 500;
+
+    QJsonArray results;
+
+    foreach (int tabs, sizes)
+    {
+        QTemporaryDir home;
+
+        if (!home.isValid())
+        {
+            fprintf(stderr, "could not create a scratch home directory\n");
+
+            return 1;
+        }
+
+        QDir(home.path()).mkpath(QStringLiteral(".config"));
+
+        if (!writeLayout(home.path() + QStringLiteral("/.config/.yakuake_layout"), tabs))
+        {
+            fprintf(stderr, "could not write a layout with %d tabs\n", tabs);
+
+            return 1;
+        }
+
+        QProcessEnvironment environment = QProcessEnvironment::systemEnvironment();
+        environment.insert(QStringLiteral("HOME"), home.path());
+        environment.insert(QStringLiteral("XDG_CONFIG_HOME"), home.path() + QStringLiteral("/.config"));
+        environment.insert(QStringLiteral("XDG_CACHE_HOME"), home.path() + QStringLiteral("/.cache"));
+        environment.insert(QStringLiteral("XDG_DATA_HOME"), home.path() + QStringLiteral("/.local/share"));
+        environment.insert(QStringLiteral("QT_QPA_PLATFORM"), QStringLiteral("offscreen"));
+
+        QProcess process;
+        process.setProcessEnvironment(environment);
+        process.setProcessChannelMode(QProcess::ForwardedErrorChannel);
+        process.start(QCoreApplication::applicationFilePath(),
+            QStringList() << QStringLiteral("--run") << QString::number(tabs));
+
+        if (!process.waitForFinished(runTimeout) || process.exitStatus() != QProcess::NormalExit
+            || process.exitCode() != 0)
+        {
+            process.kill();
+            fprintf(stderr, "run with %d tabs failed\n", tabs);
+
+            return 1;
+        }
+
+        // The result is the last line the run printed.
+        QList<QByteArray> lines = process.readAllStandardOutput().trimmed().split('\n');
+        QJsonDocument result = QJsonDocument::fromJson(lines.last());
+
+        if (!result.isObject())
+        {
+            fprintf(stderr, "run with %d tabs did not report a result\n", tabs);
+
+            return 1;
+        }
+
+        results.append(result.object());
+    }
+
+    fprintf(stdout, "%s", QJsonDocument(results).toJson().constData());
+
+    return 0;
+}
+
+int main(int argc, char* argv[])
+{
+    QElapsedTimer clock;
+    clock.start();
+
+    if (argc == 3 && qstrcmp(argv[1], "--run") == 0)
+        return runStartup(argc, argv, atoi(argv[2]), clock);
+
+    return runBenchmark(argc, argv);
+}
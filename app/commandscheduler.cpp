@@ -0,0 +1,121 @@
+/*
+  This program is free software; you can redistribute it and/or
+  modify it under the terms of the GNU General Public License as
+  published by the Free Software Foundation; either version 2 of
+  the License or (at your option) version 3 or any later version
+  accepted by the membership of KDE e.V. (or its successor appro-
+  ved by the membership of KDE e.V.), which shall act as a proxy
+  defined in Section 14 of version 3 of the license.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program. If not, see http://www.gnu.org/licenses/.
+*/
+
+
+#include "commandscheduler.h"
+#include "terminal.h"
+
+#include <QThread>
+#include <QTimer>
+
+
+// How often shells are polled for readiness while commands are pending.
+static const int dispatchInterval = 100;
+// A command holds its slot at least this long, so that a burst of commands is spread out ...
+static const int minimumStartTime = 500;
+// ... and at most this long, for commands that finish before they are seen in the foreground.
+static const int maximumStartTime = 5000;
+// Shells that never report being ready get their command after this long anyway.
+static const int maximumReadyWait = 10000;
+
+CommandScheduler::CommandScheduler(QObject* parent) : QObject(parent)
+{
+    m_limit = qMax(1, QThread::idealThreadCount());
+
+    m_dispatchTimer = new QTimer(this);
+    m_dispatchTimer->setInterval(dispatchInterval);
+    connect(m_dispatchTimer, SIGNAL(timeout()), this, SLOT(dispatch()));
+}
+
+CommandScheduler::~CommandScheduler()
+{
+}
+
+void CommandScheduler::setLimit(int limit)
+{
+    m_limit = (limit > 0) ? limit : qMax(1, QThread::idealThreadCount());
+}
+
+void CommandScheduler::enqueue(Terminal* terminal, const QString& command)
+{
+    if (!terminal || command.isEmpty()) return;
+
+    QueuedCommand queued;
+    queued.terminal = terminal;
+    queued.command = command;
+    queued.timer.start();
+
+    m_queue.append(queued);
+
+    if (!m_dispatchTimer->isActive())
+    {
+        m_dispatchTimer->start();
+
+        QMetaObject::invokeMethod(this, "dispatch", Qt::QueuedConnection);
+    }
+}
+
+bool CommandScheduler::hasStarted(StartingCommand& command)
+{
+    if (!command.terminal) return true;
+
+    qint64 elapsed = command.timer.elapsed();
+
+    if (elapsed >= maximumStartTime) return true;
+
+    return elapsed >= minimumStartTime && command.terminal->foregroundProcessId() > 0;
+}
+
+void CommandScheduler::dispatch()
+{
+    QMutableListIterator<StartingCommand> it(m_starting);
+
+    while (it.hasNext())
+    {
+        if (hasStarted(it.next()))
+            it.remove();
+    }
+
+    // Commands are started in the order they were queued, so restore is deterministic.
+    while (!m_queue.isEmpty() && m_starting.count() < m_limit)
+    {
+        QueuedCommand& next = m_queue.first();
+
+        if (!next.terminal)
+        {
+            m_queue.removeFirst();
+
+            continue;
+        }
+
+        if (!next.terminal->isShellReady() && next.timer.elapsed() < maximumReadyWait)
+            break;
+
+        next.terminal->runCommand(next.command);
+
+        StartingCommand starting;
+        starting.terminal = next.terminal;
+        starting.timer.start();
+
+        m_starting.append(starting);
+        m_queue.removeFirst();
+    }
+
+    if (m_queue.isEmpty() && m_starting.isEmpty())
+        m_dispatchTimer->stop();
+}
@@ -0,0 +1,77 @@
+/*
+  This program is free software; you can redistribute it and/or
+  modify it under the terms of the GNU General Public License as
+  published by the Free Software Foundation; either version 2 of
+  the License or (at your option) version 3 or any later version
+  accepted by the membership of KDE e.V. (or its successor appro-
+  ved by the membership of KDE e.V.), which shall act as a proxy
+  defined in Section 14 of version 3 of the license.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program. If not, see http://www.gnu.org/licenses/.
+*/
+
+
+#ifndef COMMANDSCHEDULER_H
+#define COMMANDSCHEDULER_H
+
+
+#include <QElapsedTimer>
+#include <QList>
+#include <QObject>
+#include <QPointer>
+
+
+class Terminal;
+
+class QTimer;
+
+
+class CommandScheduler : public QObject
+{
+    Q_OBJECT
+
+    public:
+        explicit CommandScheduler(QObject* parent = 0);
+         ~CommandScheduler();
+
+        int limit() { return m_limit; }
+        void setLimit(int limit);
+
+        void enqueue(Terminal* terminal, const QString& command);
+
+
+    private Q_SLOTS:
+        void dispatch();
+
+
+    private:
+        struct QueuedCommand
+        {
+            QPointer<Terminal> terminal;
+            QString command;
+            QElapsedTimer timer;
+        };
+
+        struct StartingCommand
+        {
+            QPointer<Terminal> terminal;
+            QElapsedTimer timer;
+        };
+
+        bool hasStarted(StartingCommand& command);
+
+        QList<QueuedCommand> m_queue;
+        QList<StartingCommand> m_starting;
+
+        int m_limit;
+
+        QTimer* m_dispatchTimer;
+};
+
+#endif
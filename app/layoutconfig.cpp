@@ -2,8 +2,14 @@
 
 #include <confuse.h>
 
+#include <QDataStream>
+#include <QDateTime>
 #include <QDir>
 #include <QDebug>
+#include <QFile>
+#include <QFileInfo>
+#include <QSaveFile>
+#include <QStandardPaths>
 #include <QString>
 #include <QTextStream>
 
@@ -12,6 +18,7 @@ const char *section_name_tab = "tab";
 const char *opt_name_selected = "selected";
 const char *opt_name_exec = "exec";
 const char *opt_name_locked = "locked";
+const char *opt_name_exec_limit = "exec_limit";
 
 static cfg_opt_t tab_opts[] = {
     CFG_BOOL((char*)opt_name_selected,cfg_false,CFGF_NONE),
@@ -27,6 +34,7 @@ static cfg_opt_t group_opts[] = {
 };
 
 static cfg_opt_t layout_opts[] = {
+    CFG_INT((char*)opt_name_exec_limit,0,CFGF_NONE),
     CFG_SEC((char*)section_name_group,group_opts, CFGF_MULTI | CFGF_TITLE),
     CFG_END()
 };
@@ -54,12 +62,121 @@ void cfg_reader_error(cfg_t *cfg, const char *fmt, va_list ap)
     qDebug() << s;
 }
 
+/* compiled layout cache: header followed by the QDataStream serialized groups */
+static const quint32 cache_magic = 0x594b4c43; //'YKLC'
+static const quint32 cache_version = 2;
+
 LayoutConfig::LayoutConfig()
   : _path(QDir::homePath()+QStringLiteral("/.config/.yakuake_layout")),
-    _selected_group(0)
+    _cache_path(QStandardPaths::writableLocation(QStandardPaths::CacheLocation)+QStringLiteral("/layout.cache")),
+    _selected_group(0),
+    _exec_limit(0)
 { }
 
 bool LayoutConfig::read()
+{
+    QFileInfo source(_path);
+    if(!source.exists())
+        return false;
+
+    if(read_cache(source))
+        return true;
+
+    if(!parse())
+        return false;
+
+    write_cache(source);
+    return true;
+}
+
+bool LayoutConfig::read_cache(const QFileInfo &source)
+{
+    QFile f(_cache_path);
+    if(!f.open(QIODevice::ReadOnly))
+        return false;
+
+    uchar *data = f.map(0,f.size());
+    if(!data)
+        return false;
+
+    QByteArray bytes = QByteArray::fromRawData(reinterpret_cast<const char *>(data),f.size());
+    QDataStream in(bytes);
+    in.setVersion(QDataStream::Qt_5_0);
+
+    quint32 magic, version;
+    QString path;
+    qint64 mtime, size;
+    in >> magic >> version >> path >> mtime >> size;
+    if(in.status() != QDataStream::Ok
+       || magic != cache_magic
+       || version != cache_version
+       || path != _path
+       || mtime != source.lastModified().toMSecsSinceEpoch()
+       || size != source.size())
+    {
+        return false;
+    }
+
+    qint32 selected_group, exec_limit, groups_count;
+    in >> selected_group >> exec_limit >> groups_count;
+
+    TabsGroupsList groups;
+    for(qint32 i = 0; i < groups_count && in.status() == QDataStream::Ok; i++) {
+        QString name;
+        bool locked;
+        qint32 selected_tab, tabs_count;
+        in >> name >> locked >> selected_tab >> tabs_count;
+
+        groups.push_back(TabsGroup(name));
+        TabsGroup &g = groups.back();
+        g.locked = locked;
+        g.selected_tab = selected_tab;
+
+        for(qint32 j = 0; j < tabs_count && in.status() == QDataStream::Ok; j++) {
+            QString tab_name;
+            in >> tab_name;
+            g.tabs.push_back(Tab(tab_name));
+            in >> g.tabs.back().exec;
+        }
+    }
+
+    if(in.status() != QDataStream::Ok) {
+        qDebug() << "layout cache" << _cache_path << "is corrupted, ignoring it";
+        return false;
+    }
+
+    _groups = groups;
+    _selected_group = selected_group;
+    _exec_limit = exec_limit;
+    return true;
+}
+
+void LayoutConfig::write_cache(const QFileInfo &source)
+{
+    QDir().mkpath(QFileInfo(_cache_path).absolutePath());
+
+    QSaveFile f(_cache_path);
+    if(!f.open(QIODevice::WriteOnly))
+        return;
+
+    QDataStream out(&f);
+    out.setVersion(QDataStream::Qt_5_0);
+
+    out << cache_magic << cache_version
+        << _path << qint64(source.lastModified().toMSecsSinceEpoch()) << qint64(source.size())
+        << qint32(_selected_group) << qint32(_exec_limit) << qint32(_groups.count());
+
+    for(const auto &g: _groups) {
+        out << g.name << g.locked << qint32(g.selected_tab) << qint32(g.tabs.count());
+        for(const auto &t: g.tabs)
+            out << t.name << t.exec;
+    }
+
+    if(!f.commit())
+        qDebug() << "failed to write layout cache" << _cache_path;
+}
+
+bool LayoutConfig::parse()
 {
     cfg_t *cfg =  cfg_init(layout_opts, CFGF_NONE);
     cfg_set_error_function(cfg,cfg_reader_error);
@@ -69,15 +186,20 @@ bool LayoutConfig::read()
         break;
     case CFG_FILE_ERROR:
         //qInfo() << "configuration file: " << _path << "could not be read: " << strerror(errno);
+        cfg_free(cfg);
         return false;
     case CFG_PARSE_ERROR:
         qDebug() << "configuration file" << _path << "parse error";
+        cfg_free(cfg);
         return false;
     default:
         qDebug() << "unexpected error on configuration file" << _path << "processing";
+        cfg_free(cfg);
         return false;
     }
 
+    _exec_limit = cfg_getint(cfg,opt_name_exec_limit);
+
     //iterate groups
     for(unsigned int i = 0; i < cfg_size(cfg, section_name_group); i++) {
         cfg_t *group_cfg = cfg_getnsec(cfg,section_name_group,i);
@@ -100,6 +222,7 @@ bool LayoutConfig::read()
         }
     }
 
+    cfg_free(cfg);
     return true;
 }
 
@@ -3,14 +3,26 @@
 #include <QString>
 #include <QHash>
 
+class QFileInfo;
+
 class LayoutConfig
 {
 public:
     struct Tab {
         QString name;
         QString exec;
+        //split tree and lock flag, only known when restoring from the session journal
+        QString layout;
+        //name of the layout file entry the tab was created from, only known from the session journal
+        QString origin;
+        bool closable;
         Tab(const char *name)
-          : name(QString::fromUtf8(name))
+          : name(QString::fromUtf8(name)),
+            closable(true)
+        { }
+        Tab(const QString &name)
+          : name(name),
+            closable(true)
         { }
     };
     typedef QList<Tab> TabsList;
@@ -20,22 +32,38 @@ public:
         TabsList tabs;
         int selected_tab;
         bool locked;
+        //whether the group was created from the layout file, only known from the session journal
+        bool from_layout;
         TabsGroup(const char *name)
           : name(QString::fromUtf8(name)),
-            selected_tab(0)
+            selected_tab(0),
+            from_layout(false)
+        { }
+        TabsGroup(const QString &name)
+          : name(name),
+            selected_tab(0),
+            from_layout(false)
         { }
     };
     typedef QList<TabsGroup> TabsGroupsList;
 
 private:
     QString _path;
+    QString _cache_path;
     TabsGroupsList _groups;
     int _selected_group;
+    int _exec_limit;
+
+    bool parse();
+    bool read_cache(const QFileInfo &source);
+    void write_cache(const QFileInfo &source);
 
 public:
     LayoutConfig();
     bool read();
 
+    const QString &path() { return _path; }
     const TabsGroupsList &groups() { return _groups; }
     int active_group() { return _selected_group; }
+    int exec_limit() { return _exec_limit; }
 };
@@ -19,6 +19,7 @@
 */
 
 #include "mainwindow.h"
+#include "metrics.h"
 
 #include <KAboutData>
 #include <KCrash>
@@ -27,12 +28,18 @@
 
 #include <QApplication>
 #include <QCommandLineParser>
+#include <QElapsedTimer>
 
 int main (int argc, char *argv[])
 {
+    QElapsedTimer startupClock;
+    startupClock.start();
+
     QApplication app(argc, argv);
     app.setQuitOnLastWindowClosed(false);
 
+    Metrics::self()->startStartupTimeline(startupClock);
+
     KLocalizedString::setApplicationDomain("yakuake");
 
     KAboutData aboutData(QStringLiteral("yakuake"),
@@ -79,10 +86,12 @@ int main (int argc, char *argv[])
     app.setWindowIcon(QIcon::fromTheme(QStringLiteral("yakuake")));
 
     KDBusService service(KDBusService::Unique);
+    Metrics::self()->addStartupPhase(QStringLiteral("main"), 0);
 
     KCrash::initialize();
     MainWindow mainWindow;
     mainWindow.hide();
+    Metrics::self()->finishStartupTimeline();
     QObject::connect(&service, SIGNAL(activateRequested(QStringList, QString)), &mainWindow, SLOT(toggleWindowState()));
 
     return app.exec();
@@ -25,10 +25,12 @@
 #include "config/appearancesettings.h"
 #include "config/windowsettings.h"
 #include "firstrundialog.h"
+#include "metrics.h"
 #include "sessionstack.h"
 #include "skin.h"
 #include "tabbar.h"
 #include "terminal.h"
+#include "terminalpool.h"
 #include "titlebar.h"
 #include "ui_behaviorsettings.h"
 
@@ -49,8 +51,10 @@
 
 #include <QApplication>
 #include <QDesktopWidget>
+#include <QLabel>
 #include <QMenu>
 #include <QPainter>
+#include <QScreen>
 #include <QWhatsThis>
 #include <QWindow>
 #include <QtDBus/QtDBus>
@@ -99,8 +103,28 @@ MainWindow::MainWindow(QWidget* parent)
 
     m_toggleLock = false;
 
+    m_windowGeometryDirty = true;
+    m_windowGeometryScreen = -1;
+
+    m_toggleMeasuring = false;
+    m_toggleWindowPainted = false;
+
+    m_animationTimer.setTimerType(Qt::PreciseTimer);
+    m_animationLastFrame = 0;
+
+    m_animationSnapshot = new QLabel(this);
+    m_animationSnapshot->setAttribute(Qt::WA_OpaquePaintEvent);
+    m_animationSnapshot->hide();
+
+    Metrics* metrics = Metrics::self();
+
+    qint64 phaseStart = metrics->elapsed();
     setupActions();
+    metrics->addStartupPhase(QStringLiteral("setupActions"), phaseStart);
+
+    phaseStart = metrics->elapsed();
     setupMenu();
+    metrics->addStartupPhase(QStringLiteral("setupMenu"), phaseStart);
 
     connect(m_tabBar, SIGNAL(newTabRequested()), m_sessionStack, SLOT(addSession()));
     connect(m_tabBar, SIGNAL(lastTabClosed()), m_tabBar, SIGNAL(newTabRequested()));
@@ -118,15 +142,36 @@ MainWindow::MainWindow(QWidget* parent)
     connect(m_sessionStack, SIGNAL(sessionRemoved(int)), m_tabBar, SLOT(removeTab(int)));
     connect(m_sessionStack, SIGNAL(activeTitleChanged(QString)),
         m_titleBar, SLOT(setTitle(QString)));
+    connect(m_sessionStack, SIGNAL(sessionClosableChanged(int,bool)),
+        m_tabBar->journal(), SLOT(setTabClosable(int,bool)));
+    connect(m_sessionStack, SIGNAL(sessionClosableChanged(int,bool)),
+        m_tabBar, SLOT(updateTab(int)));
+    connect(m_sessionStack, SIGNAL(sessionLayoutChanged(int,QString)),
+        m_tabBar->journal(), SLOT(setTabLayout(int,QString)));
 
     connect(&m_mousePoller, SIGNAL(timeout()), this, SLOT(pollMouse()));
 
+    connect(KWindowSystem::self(), SIGNAL(workAreaChanged()), this, SLOT(invalidateWorkArea()));
+    connect(KWindowSystem::self(), SIGNAL(strutChanged()), this, SLOT(invalidateWorkArea()));
+    connect(KWindowSystem::self(), SIGNAL(windowAdded(WId)), this, SLOT(workAreaWindowAdded(WId)));
+    connect(KWindowSystem::self(), SIGNAL(windowRemoved(WId)), this, SLOT(workAreaWindowRemoved(WId)));
+    connect(KWindowSystem::self(), SIGNAL(windowChanged(WId,NET::Properties,NET::Properties2)),
+        this, SLOT(workAreaWindowChanged(WId,NET::Properties,NET::Properties2)));
+    connect(QApplication::desktop(), SIGNAL(screenCountChanged(int)), this, SLOT(invalidateWorkArea()));
+    connect(QApplication::desktop(), SIGNAL(resized(int)), this, SLOT(invalidateWorkArea()));
     connect(KWindowSystem::self(), SIGNAL(workAreaChanged()), this, SLOT(applyWindowGeometry()));
+    connect(KWindowSystem::self(), SIGNAL(compositingChanged(bool)), this, SLOT(updateUseTranslucency()));
     connect(QApplication::desktop(), SIGNAL(screenCountChanged(int)), this, SLOT(updateScreenMenu()));
+    connect(QApplication::desktop(), SIGNAL(screenCountChanged(int)), this, SLOT(invalidateWindowGeometry()));
+    connect(QApplication::desktop(), SIGNAL(resized(int)), this, SLOT(invalidateWindowGeometry()));
 
+    phaseStart = metrics->elapsed();
     applySettings();
+    metrics->addStartupPhase(QStringLiteral("applySettings"), phaseStart);
 
+    phaseStart = metrics->elapsed();
     m_tabBar->restoreGroupsFromSettings();
+    metrics->addStartupPhase(QStringLiteral("restoreGroupsFromSettings"), phaseStart);
 
     if (Settings::firstRun())
     {
@@ -320,6 +365,24 @@ void MainWindow::setupActions()
     action->setShortcut(QKeySequence(Qt::SHIFT + Qt::Key_Right));
     connect(action, SIGNAL(triggered()), m_tabBar, SLOT(selectNextTab()));
 
+    action = actionCollection()->addAction(QStringLiteral("scroll-tabs-left"));
+    action->setText(xi18nc("@action", "Scroll Tab Bar Left"));
+    action->setIcon(QIcon(QStringLiteral("go-previous")));
+    action->setShortcut(QKeySequence(Qt::ALT + Qt::SHIFT + Qt::Key_PageUp));
+    connect(action, SIGNAL(triggered()), m_tabBar, SLOT(scrollTabsLeft()));
+
+    action = actionCollection()->addAction(QStringLiteral("scroll-tabs-right"));
+    action->setText(xi18nc("@action", "Scroll Tab Bar Right"));
+    action->setIcon(QIcon(QStringLiteral("go-next")));
+    action->setShortcut(QKeySequence(Qt::ALT + Qt::SHIFT + Qt::Key_PageDown));
+    connect(action, SIGNAL(triggered()), m_tabBar, SLOT(scrollTabsRight()));
+
+    action = actionCollection()->addAction(QStringLiteral("quick-switch"));
+    action->setText(xi18nc("@action", "Quick Switch to Session..."));
+    action->setIcon(QIcon(QStringLiteral("edit-find")));
+    action->setShortcut(QKeySequence(Qt::CTRL + Qt::SHIFT + Qt::Key_Space));
+    connect(action, SIGNAL(triggered()), m_tabBar, SLOT(openQuickSwitcher()));
+
     action = actionCollection()->addAction(QStringLiteral("move-session-left"));
     action->setText(xi18nc("@action", "Move Session Left"));
     action->setIcon(QIcon(QStringLiteral("arrow-left")));
@@ -555,11 +618,8 @@ void MainWindow::handleContextDependentToggleAction(bool checked, QAction* actio
     if (!action) action = qobject_cast<QAction*>(QObject::sender());
 
     if (action == actionCollection()->action(QStringLiteral("toggle-session-prevent-closing"))) {
+        // The tab bar picks up the lock icon change via sessionClosableChanged().
         m_sessionStack->setSessionClosable(sessionId, !checked);
-
-        // Repaint the tab bar when the Prevent Closing action is toggled
-        // so the lock icon is added to or removed from the tab label.
-        m_tabBar->repaint();
     }
 
     if (action == actionCollection()->action(QStringLiteral("toggle-session-keyboard-input")))
@@ -583,7 +643,6 @@ void MainWindow::handleContextDependentGroupToggleAction(bool checked, QAction*
     if (!action) action = qobject_cast<QAction*>(QObject::sender());
     if (action == actionCollection()->action(QStringLiteral("toggle-group-prevent-closing"))) {
         m_tabBar->setGroupLocked(group_id,checked);
-        m_tabBar->repaint();
     }
 }
 
@@ -855,7 +914,9 @@ void MainWindow::applySettings()
             m_tabBar, SLOT(setTabTitle(int,QString)));
     }
 
-    m_animationTimer.setInterval(Settings::frames() ? 10 : 0);
+    m_sessionStack->terminalPool()->scheduleRefill();
+
+    m_tabBar->applySettings();
 
     m_tabBar->setVisible(Settings::showTabBar());
 
@@ -873,6 +934,10 @@ void MainWindow::applySettings()
 
 void MainWindow::applySkin()
 {
+    qint64 skinLoadStart = Metrics::self()->elapsed();
+
+    m_skin->setDevicePixelRatio(getScreenPixelRatio());
+
     bool gotSkin = m_skin->load(Settings::skin(), Settings::skinInstalledWithKns());
 
     if (!gotSkin)
@@ -881,6 +946,8 @@ void MainWindow::applySkin()
         gotSkin = m_skin->load(Settings::skin());
     }
 
+    Metrics::self()->addStartupPhase(QStringLiteral("skin"), skinLoadStart);
+
     if (!gotSkin)
     {
         KMessageBox::error(parentWidget(),
@@ -932,6 +999,16 @@ void MainWindow::setWindowGeometry(int newWidth, int newHeight, int newPosition)
 {
     QRect workArea = getDesktopGeometry();
 
+    m_windowGeometryDirty = false;
+    m_windowGeometryScreen = getScreen();
+
+    // Moving to a screen with another scale only swaps in the skin images rendered for it.
+    if (m_skin->setDevicePixelRatio(getScreenPixelRatio()))
+    {
+        m_titleBar->applySkin();
+        m_tabBar->applySkin();
+    }
+
     int maxHeight = workArea.height() * newHeight / 100;
 
     int targetWidth = workArea.width() * newWidth / 100;
@@ -952,11 +1029,6 @@ void MainWindow::setWindowGeometry(int newWidth, int newHeight, int newPosition)
     m_titleBar->setGeometry(0, maxHeight, targetWidth, m_titleBar->height());
     if (!isVisible()) m_titleBar->updateMask();
 
-    if (Settings::frames() > 0)
-        m_animationStepSize = maxHeight / Settings::frames();
-    else
-        m_animationStepSize = maxHeight;
-
     if (Settings::showTabBar())
     {
         maxHeight -= m_tabBar->height();
@@ -1062,6 +1134,15 @@ void MainWindow::paintEvent(QPaintEvent* event)
     painter.fillRect(rightBorder, m_skin->borderColor());
 
     QMainWindow::paintEvent(event);
+
+    m_paintedSize = size();
+
+    if (m_toggleMeasuring && !m_toggleWindowPainted)
+    {
+        m_toggleWindowPainted = true;
+
+        finishToggleLatency();
+    }
 }
 
 void MainWindow::moveEvent(QMoveEvent* event)
@@ -1115,8 +1196,67 @@ void MainWindow::changeEvent(QEvent* event)
     QMainWindow::changeEvent(event);
 }
 
+QString MainWindow::startupTimeline()
+{
+    return Metrics::self()->startupTimeline();
+}
+
+QString MainWindow::toggleLatencyHistogram()
+{
+    return Metrics::self()->toggleLatencyHistogram();
+}
+
+void MainWindow::measureToggleLatency(const QString& backend)
+{
+    // An open is done once the window and its active terminal have both painted.
+    cancelToggleLatency();
+
+    m_toggleBackend = backend;
+    m_toggleWindowPainted = false;
+
+    m_toggleTerminalWidget = m_sessionStack->activeTerminalWidget();
+
+    if (m_toggleTerminalWidget)
+        m_toggleTerminalWidget->installEventFilter(this);
+
+    m_toggleMeasuring = true;
+}
+
+void MainWindow::cancelToggleLatency()
+{
+    if (m_toggleTerminalWidget)
+        m_toggleTerminalWidget->removeEventFilter(this);
+
+    m_toggleTerminalWidget = 0;
+    m_toggleMeasuring = false;
+}
+
+void MainWindow::finishToggleLatency()
+{
+    if (!m_toggleMeasuring || !m_toggleWindowPainted || m_toggleTerminalWidget) return;
+
+    m_toggleMeasuring = false;
+
+    Metrics::self()->recordToggleLatency(m_toggleBackend, m_toggleClock.nsecsElapsed());
+}
+
+bool MainWindow::eventFilter(QObject* watched, QEvent* event)
+{
+    if (watched == m_toggleTerminalWidget && event->type() == QEvent::Paint)
+    {
+        m_toggleTerminalWidget->removeEventFilter(this);
+        m_toggleTerminalWidget = 0;
+
+        finishToggleLatency();
+    }
+
+    return QMainWindow::eventFilter(watched, event);
+}
+
 void MainWindow::toggleWindowState()
 {
+    m_toggleClock.start();
+
     bool visible = isVisible();
 
     if (visible && KWindowSystem::activeWindow() != winId() && Settings::keepOpen())
@@ -1179,6 +1319,8 @@ void MainWindow::toggleWindowState()
         }
         else
         {
+            measureToggleLatency(QStringLiteral("wayland"));
+
             sharedPreOpenWindow();
             if (KWindowEffects::isEffectAvailable(KWindowEffects::Slide)) {
                 KWindowEffects::slideWindow(this, KWindowEffects::TopEdge);
@@ -1239,6 +1381,8 @@ void MainWindow::kwinAssistToggleWindowState(bool visible)
         }
         else
         {
+            measureToggleLatency(QStringLiteral("kwin"));
+
             sharedPreOpenWindow();
 
             show();
@@ -1272,83 +1416,196 @@ void MainWindow::xshapeToggleWindowState(bool visible)
 {
     if (m_animationTimer.isActive()) return;
 
+    // Ticks follow the refresh rate of the screen, but where the window is drawn
+    // only depends on the time since the animation started.
+    QScreen* screen = windowHandle() ? windowHandle()->screen() : QGuiApplication::primaryScreen();
+    qreal refreshRate = screen ? screen->refreshRate() : 0;
+
+    m_animationTimer.setInterval(refreshRate > 0 ? qMax(1, qRound(1000 / refreshRate)) : 16);
+
     if (visible)
     {
         sharedPreHideWindow();
 
-        m_animationFrame = Settings::frames();
+        showAnimationSnapshot();
 
         connect(&m_animationTimer, SIGNAL(timeout()), this, SLOT(xshapeRetractWindow()));
-        m_animationTimer.start();
     }
     else
     {
-        m_animationFrame = 0;
-
-        connect(&m_animationTimer, SIGNAL(timeout()), this, SLOT(xshapeOpenWindow()));
-        m_animationTimer.start();
-    }
-}
+        measureToggleLatency(QStringLiteral("xshape"));
 
-void MainWindow::xshapeOpenWindow()
-{
-    if (m_animationFrame == 0)
-    {
         sharedPreOpenWindow();
 
+        m_titleBar->move(0, height() - m_titleBar->height());
+        showAnimationSnapshot();
+
         show();
 
         sharedAfterOpenWindow();
+
+        connect(&m_animationTimer, SIGNAL(timeout()), this, SLOT(xshapeOpenWindow()));
     }
 
-    if (m_animationFrame == Settings::frames())
-    {
-        m_animationTimer.stop();
-        m_animationTimer.disconnect();
+    Metrics::self()->startAnimation();
 
-        m_titleBar->move(0, height() - m_titleBar->height());
-        updateMask();
-    }
+    m_animationClock.start();
+    m_animationLastFrame = 0;
+    m_animationTimer.start();
+
+    // The first frame goes out now rather than one tick later.
+    if (visible)
+        xshapeRetractWindow();
     else
-    {
-        int maskHeight = m_animationStepSize * m_animationFrame;
+        xshapeOpenWindow();
+}
+
+qreal MainWindow::animationProgress(QEasingCurve::Type easing)
+{
+    qint64 elapsed = m_animationClock.nsecsElapsed();
+
+    if (m_animationLastFrame > 0)
+        Metrics::self()->recordAnimationFrame(elapsed - m_animationLastFrame);
+
+    m_animationLastFrame = elapsed;
+
+    // Settings::frames() used to count 10 ms ticks; it now sets the duration.
+    qint64 duration = Settings::frames() * 10 * 1000000LL;
+
+    if (elapsed >= duration)
+        return 1.0;
+
+    return QEasingCurve(easing).valueForProgress(qreal(elapsed) / duration);
+}
 
-        QRegion newMask = m_titleBar->mask();
-        newMask.translate(0, maskHeight);
-        newMask += QRegion(0, 0, width(), maskHeight);
+void MainWindow::finishAnimation()
+{
+    m_animationTimer.stop();
+    m_animationTimer.disconnect();
+
+    m_animationSnapshot->hide();
+    m_animationSnapshot->clear();
+
+    Metrics::self()->finishAnimation(m_animationClock.nsecsElapsed());
+}
+
+void MainWindow::showAnimationSnapshot()
+{
+    // A translucent snapshot would let the live widgets below show through, so
+    // those still have to be animated directly.
+    if (!Settings::snapshotAnimation() || m_useTranslucency) return;
+
+    // Until the window has been painted at its current size the terminals have
+    // no layout yet and grab() would render them blank or at a stale size.
+    if (m_paintedSize != size()) return;
 
+    // The snapshot is opaque and covers everything, so the terminals below it are
+    // not painted again until it is hidden.
+    m_animationSnapshot->setPixmap(grab());
+    m_animationSnapshot->setGeometry(rect());
+    m_animationSnapshot->raise();
+    m_animationSnapshot->show();
+}
+
+void MainWindow::setAnimationHeight(int maskHeight)
+{
+    QRegion newMask = m_titleBar->mask();
+    newMask.translate(0, maskHeight);
+    newMask += QRegion(0, 0, width(), maskHeight);
+
+    if (m_animationSnapshot->isVisible())
+        m_animationSnapshot->move(0, maskHeight - (height() - m_titleBar->height()));
+    else
         m_titleBar->move(0, maskHeight);
-        setMask(newMask);
 
-        m_animationFrame++;
+    setMask(newMask);
+}
+
+void MainWindow::xshapeOpenWindow()
+{
+    qreal progress = animationProgress(QEasingCurve::OutCubic);
+
+    if (progress >= 1.0)
+    {
+        finishAnimation();
+
+        m_titleBar->move(0, height() - m_titleBar->height());
+        updateMask();
     }
+    else
+        setAnimationHeight(qRound((height() - m_titleBar->height()) * progress));
 }
 
 void MainWindow::xshapeRetractWindow()
 {
-    if (m_animationFrame == 0)
-    {
-        m_animationTimer.stop();
-        m_animationTimer.disconnect();
+    qreal progress = animationProgress(QEasingCurve::InCubic);
 
+    if (progress >= 1.0)
+    {
         hide();
 
+        finishAnimation();
+
+        // Leave the hidden window whole; the next open may not reapply its geometry.
+        m_titleBar->move(0, height() - m_titleBar->height());
+        updateMask();
+
         sharedAfterHideWindow();
     }
     else
-    {
-        m_titleBar->move(0,m_titleBar->y() - m_animationStepSize);
-        setMask(QRegion(mask()).translated(0, -m_animationStepSize));
+        setAnimationHeight(qRound((height() - m_titleBar->height()) * (1.0 - progress)));
+}
 
-        --m_animationFrame;
-    }
+void MainWindow::invalidateWindowGeometry()
+{
+    m_windowGeometryDirty = true;
+}
+
+void MainWindow::invalidateWorkArea()
+{
+    m_workAreaCache.clear();
+    m_strutWindows.clear();
+}
+
+void MainWindow::workAreaWindowAdded(WId windowId)
+{
+    if (m_workAreaCache.isEmpty() || !KWindowSystem::hasWId(windowId)) return;
+
+    // Only windows reserving screen space change the work area.
+    KWindowInfo windowInfo(windowId, 0, NET::WM2ExtendedStrut);
+    NETExtendedStrut strut = windowInfo.extendedStrut();
+
+    if (strut.top_width || strut.bottom_width || strut.left_width || strut.right_width)
+        invalidateWorkArea();
+}
+
+void MainWindow::workAreaWindowRemoved(WId windowId)
+{
+    if (m_strutWindows.contains(windowId))
+        invalidateWorkArea();
+}
+
+void MainWindow::workAreaWindowChanged(WId windowId, NET::Properties properties, NET::Properties2 properties2)
+{
+    if (!(properties & NET::WMDesktop) && !(properties2 & NET::WM2ExtendedStrut)) return;
+
+    // A known strut window moving desktops or changing its strut, or another window
+    // gaining a strut.
+    if (m_strutWindows.contains(windowId))
+        invalidateWorkArea();
+    else
+        workAreaWindowAdded(windowId);
 }
 
 void MainWindow::sharedPreOpenWindow()
 {
-    applyWindowGeometry();
+    // In warm standby the hidden window keeps its geometry and translucency; the
+    // signals connected in the constructor keep both current.
+    if (!Settings::warmStandby() || m_windowGeometryDirty || getScreen() != m_windowGeometryScreen)
+        applyWindowGeometry();
 
-    updateUseTranslucency();
+    if (!Settings::warmStandby())
+        updateUseTranslucency();
 
     if (Settings::pollMouse()) toggleMousePoll(false);
 }
@@ -1367,6 +1624,8 @@ void MainWindow::sharedAfterOpenWindow()
 
 void MainWindow::sharedPreHideWindow()
 {
+    cancelToggleLatency();
+
     disconnect(KWindowSystem::self(), &KWindowSystem::activeWindowChanged,
         this, &MainWindow::wmActiveWindowChanged);
 }
@@ -1439,6 +1698,17 @@ int MainWindow::getScreen()
         return Settings::screen() - 1;
 }
 
+qreal MainWindow::getScreenPixelRatio()
+{
+    QList<QScreen*> screens = QGuiApplication::screens();
+    int screen = getScreen();
+
+    if (screen < 0 || screen >= screens.count())
+        return qApp->devicePixelRatio();
+
+    return screens.at(screen)->devicePixelRatio();
+}
+
 QRect MainWindow::getDesktopGeometry()
 {
     QRect screenGeometry = QApplication::desktop()->screenGeometry(getScreen());
@@ -1453,6 +1723,24 @@ QRect MainWindow::getDesktopGeometry()
         return screenGeometry;
     }
 
+    // Computing the work area queries every window's strut, so it's only redone
+    // once the signals connected in the constructor have invalidated it.
+    QPair<int, int> key(getScreen(), KWindowSystem::currentDesktop());
+
+    QHash<QPair<int, int>, QRect>::const_iterator it = m_workAreaCache.constFind(key);
+
+    if (it != m_workAreaCache.constEnd())
+        return it.value();
+
+    QRect workArea = computeDesktopGeometry(screenGeometry);
+
+    m_workAreaCache.insert(key, workArea);
+
+    return workArea;
+}
+
+QRect MainWindow::computeDesktopGeometry(const QRect& screenGeometry)
+{
     if (QApplication::desktop()->screenCount() > 1)
     {
         const QList<WId> allWindows = KWindowSystem::windows();
@@ -1468,9 +1756,7 @@ QRect MainWindow::getDesktopGeometry()
             {
                 KWindowInfo windowInfo = KWindowInfo(windowId, NET::WMDesktop, NET::WM2ExtendedStrut);
 
-                // If windowInfo is valid and the window is located at the same (current)
-                // desktop with the yakuake window...
-                if (windowInfo.valid() && windowInfo.isOnCurrentDesktop())
+                if (windowInfo.valid())
                 {
                     NETExtendedStrut strut = windowInfo.extendedStrut();
 
@@ -1486,6 +1772,14 @@ QRect MainWindow::getDesktopGeometry()
                     if (topStrut.isEmpty() && bottomStrut.isEmpty() && leftStrut.isEmpty() && rightStrut.isEmpty())
                         continue;
 
+                    // Strut windows on every desktop are remembered, as the work area cached for
+                    // their desktop depends on them.
+                    m_strutWindows << windowId;
+
+                    // Only windows located at the same (current) desktop with the yakuake window matter here.
+                    if (!windowInfo.isOnCurrentDesktop())
+                        continue;
+
                     // If any of the strut intersects with our screen geometry, it will be correctly handled
                     // by workArea().
                     if (topStrut.intersects(screenGeometry) || bottomStrut.intersects(screenGeometry) ||
@@ -25,7 +25,15 @@
 
 #include "config-yakuake.h"
 
+#include <netwm_def.h>
+
+#include <QEasingCurve>
+#include <QElapsedTimer>
+#include <QHash>
 #include <QMainWindow>
+#include <QPair>
+#include <QPointer>
+#include <QSet>
 
 #include <QTimer>
 
@@ -42,6 +50,8 @@ class TitleBar;
 class KHelpMenu;
 class KActionCollection;
 
+class QLabel;
+
 #if HAVE_KWAYLAND
 namespace KWayland {
     namespace Client {
@@ -73,6 +83,9 @@ class MainWindow : public QMainWindow
     public Q_SLOTS:
         Q_SCRIPTABLE void toggleWindowState();
 
+        Q_SCRIPTABLE QString startupTimeline();
+        Q_SCRIPTABLE QString toggleLatencyHistogram();
+
         void handleContextDependentGroupAction(QAction* action = 0, int group_id = -1);
         void handleContextDependentGroupToggleAction(bool checked, QAction* action = 0, int group_id = -1);
         void handleContextDependentAction(QAction* action = 0, int sessionId = -1);
@@ -94,6 +107,7 @@ class MainWindow : public QMainWindow
         virtual void paintEvent(QPaintEvent*);
         virtual void moveEvent(QMoveEvent*);
         virtual void changeEvent(QEvent* event);
+        virtual bool eventFilter(QObject* watched, QEvent* event);
 
         virtual bool queryClose();
 
@@ -105,6 +119,12 @@ class MainWindow : public QMainWindow
 
         void applyWindowGeometry();
         void setWindowGeometry(int width, int height, int position);
+        void invalidateWindowGeometry();
+
+        void invalidateWorkArea();
+        void workAreaWindowAdded(WId windowId);
+        void workAreaWindowRemoved(WId windowId);
+        void workAreaWindowChanged(WId windowId, NET::Properties properties, NET::Properties2 properties2);
 
         void updateScreenMenu();
         void setScreen(QAction* action);
@@ -121,6 +141,8 @@ class MainWindow : public QMainWindow
 
         void wmActiveWindowChanged();
 
+        void updateUseTranslucency();
+
         void xshapeOpenWindow();
         void xshapeRetractWindow();
 
@@ -162,6 +184,10 @@ class MainWindow : public QMainWindow
 #endif
 
         void xshapeToggleWindowState(bool visible);
+        qreal animationProgress(QEasingCurve::Type easing);
+        void setAnimationHeight(int maskHeight);
+        void showAnimationSnapshot();
+        void finishAnimation();
 
         void sharedPreOpenWindow();
         void sharedAfterOpenWindow();
@@ -171,13 +197,24 @@ class MainWindow : public QMainWindow
         void updateMask();
 
         int getScreen();
+        qreal getScreenPixelRatio();
         QRect getDesktopGeometry();
+        QRect computeDesktopGeometry(const QRect& screenGeometry);
 
         void showStartupPopup();
 
-        void updateUseTranslucency();
+        void measureToggleLatency(const QString& backend);
+        void cancelToggleLatency();
+        void finishToggleLatency();
+
         bool m_useTranslucency;
 
+        bool m_windowGeometryDirty;
+        int m_windowGeometryScreen;
+
+        QHash<QPair<int, int>, QRect> m_workAreaCache;
+        QSet<WId> m_strutWindows;
+
         KActionCollection* m_actionCollection;
         QList<QAction*> m_contextDependentActions;
 
@@ -196,8 +233,16 @@ class MainWindow : public QMainWindow
 
         QTimer m_animationTimer;
         QTimer m_mousePoller;
-        int m_animationFrame;
-        int m_animationStepSize;
+        QElapsedTimer m_animationClock;
+        qint64 m_animationLastFrame;
+        QLabel* m_animationSnapshot;
+        QSize m_paintedSize;
+
+        QElapsedTimer m_toggleClock;
+        QString m_toggleBackend;
+        bool m_toggleMeasuring;
+        bool m_toggleWindowPainted;
+        QPointer<QWidget> m_toggleTerminalWidget;
 
         bool m_toggleLock;
 
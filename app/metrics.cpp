@@ -0,0 +1,244 @@
+/*
+  This program is free software; you can redistribute it and/or
+  modify it under the terms of the GNU General Public License as
+  published by the Free Software Foundation; either version 2 of
+  the License or (at your option) version 3 or any later version
+  accepted by the membership of KDE e.V. (or its successor appro-
+  ved by the membership of KDE e.V.), which shall act as a proxy
+  defined in Section 14 of version 3 of the license.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program. If not, see http://www.gnu.org/licenses/.
+*/
+
+
+#include "metrics.h"
+
+#include <QApplication>
+#include <QPointer>
+#include <QStringList>
+
+#include <algorithm>
+#include <cstdio>
+
+#include <QtDBus/QtDBus>
+
+
+static const int toggleLatencySamples = 500;
+
+
+static QString formatMilliseconds(qint64 nsecs)
+{
+    return QString::number(nsecs / 1000000.0, 'f', 2);
+}
+
+static qint64 percentile(QList<qint64> samples, int percent)
+{
+    if (samples.isEmpty()) return 0;
+
+    std::sort(samples.begin(), samples.end());
+
+    // Nearest rank.
+    int rank = qBound(1, (percent * samples.count() + 99) / 100, samples.count());
+
+    return samples.at(rank - 1);
+}
+
+Metrics* Metrics::self()
+{
+    static QPointer<Metrics> instance;
+
+    if (!instance) instance = new Metrics(qApp);
+
+    return instance;
+}
+
+Metrics::Metrics(QObject* parent) : QObject(parent)
+{
+    QDBusConnection::sessionBus().registerObject(QStringLiteral("/yakuake/metrics"), this, QDBusConnection::ExportScriptableSlots);
+
+    m_startupClock.start();
+    m_startingUp = false;
+
+    m_partCreationTotal = 0;
+    m_partCreationCount = 0;
+
+    m_terminalPoolHits = 0;
+    m_terminalPoolMisses = 0;
+
+    m_tabPixmapCacheHits = 0;
+    m_tabPixmapCacheMisses = 0;
+
+    m_animationCount = 0;
+    m_lastAnimationDuration = 0;
+    m_animationFrameTotal = 0;
+    m_animationFrameMaximum = 0;
+    m_animationFrameCount = 0;
+}
+
+void Metrics::startStartupTimeline(const QElapsedTimer& clock)
+{
+    m_startupClock = clock;
+    m_startupPhases.clear();
+    m_startingUp = true;
+}
+
+void Metrics::finishStartupTimeline()
+{
+    if (!m_startingUp) return;
+
+    addStartupPhase(QStringLiteral("total"), 0);
+
+    m_startingUp = false;
+
+    if (!qEnvironmentVariableIsEmpty("YAKUAKE_STARTUP_TIMELINE"))
+        fprintf(stderr, "%s\n", qPrintable(startupTimeline()));
+}
+
+void Metrics::addStartupPhase(const QString& name, qint64 start)
+{
+    if (!m_startingUp) return;
+
+    StartupPhase phase;
+    phase.name = name;
+    phase.start = start;
+    phase.end = elapsed();
+
+    m_startupPhases.append(phase);
+}
+
+const QString Metrics::startupTimeline()
+{
+    // One phase per line: name, start and duration in milliseconds since main().
+    QStringList lines;
+
+    foreach (const StartupPhase& phase, m_startupPhases)
+    {
+        lines << phase.name + QLatin1Char(' ') + formatMilliseconds(phase.start)
+            + QLatin1Char(' ') + formatMilliseconds(phase.end - phase.start);
+    }
+
+    return lines.join(QStringLiteral("\n"));
+}
+
+void Metrics::recordPartCreation(int terminalId, qint64 nsecs)
+{
+    m_partCreationTimes.insert(terminalId, nsecs);
+
+    m_partCreationTotal += nsecs;
+    ++m_partCreationCount;
+}
+
+void Metrics::removeTerminal(int terminalId)
+{
+    m_partCreationTimes.remove(terminalId);
+    m_spareTerminals.remove(terminalId);
+}
+
+const QString Metrics::partCreationTimes()
+{
+    QStringList times;
+
+    QMapIterator<int, qint64> it(m_partCreationTimes);
+
+    while (it.hasNext())
+    {
+        it.next();
+
+        times << QString::number(it.key()) + QLatin1Char(':') + formatMilliseconds(it.value());
+    }
+
+    return times.join(QStringLiteral(","));
+}
+
+double Metrics::averagePartCreationTime()
+{
+    if (m_partCreationCount == 0) return 0;
+
+    return (m_partCreationTotal / m_partCreationCount) / 1000000.0;
+}
+
+double Metrics::tabPixmapCacheHitRate()
+{
+    int lookups = m_tabPixmapCacheHits + m_tabPixmapCacheMisses;
+
+    if (lookups == 0) return 0;
+
+    return double(m_tabPixmapCacheHits) / lookups;
+}
+
+void Metrics::startAnimation()
+{
+    m_animationFrameTimes.clear();
+}
+
+void Metrics::recordAnimationFrame(qint64 nsecs)
+{
+    m_animationFrameTimes << nsecs;
+
+    m_animationFrameTotal += nsecs;
+    m_animationFrameMaximum = qMax(m_animationFrameMaximum, nsecs);
+    ++m_animationFrameCount;
+}
+
+void Metrics::finishAnimation(qint64 nsecs)
+{
+    m_lastAnimationDuration = nsecs;
+    ++m_animationCount;
+}
+
+const QString Metrics::lastAnimationFrameTimes()
+{
+    QStringList times;
+
+    foreach (qint64 nsecs, m_animationFrameTimes)
+        times << formatMilliseconds(nsecs);
+
+    return times.join(QStringLiteral(","));
+}
+
+double Metrics::averageAnimationFrameTime()
+{
+    if (m_animationFrameCount == 0) return 0;
+
+    return (m_animationFrameTotal / m_animationFrameCount) / 1000000.0;
+}
+
+void Metrics::recordToggleLatency(const QString& backend, qint64 nsecs)
+{
+    QList<qint64>& samples = m_toggleLatencies[backend];
+
+    samples << nsecs;
+
+    if (samples.count() > toggleLatencySamples)
+        samples.removeFirst();
+}
+
+const QString Metrics::toggleLatencyHistogram()
+{
+    QStringList lines;
+
+    QMapIterator<QString, QList<qint64> > it(m_toggleLatencies);
+
+    while (it.hasNext())
+    {
+        it.next();
+
+        lines << it.key() + QLatin1Char(' ') + QString::number(it.value().count())
+            + QLatin1Char(' ') + formatMilliseconds(percentile(it.value(), 50))
+            + QLatin1Char(' ') + formatMilliseconds(percentile(it.value(), 95))
+            + QLatin1Char(' ') + formatMilliseconds(percentile(it.value(), 99));
+    }
+
+    return lines.join(QStringLiteral("\n"));
+}
+
+double Metrics::toggleLatencyPercentile(const QString& backend, int percent)
+{
+    return percentile(m_toggleLatencies.value(backend), percent) / 1000000.0;
+}
@@ -0,0 +1,126 @@
+/*
+  This program is free software; you can redistribute it and/or
+  modify it under the terms of the GNU General Public License as
+  published by the Free Software Foundation; either version 2 of
+  the License or (at your option) version 3 or any later version
+  accepted by the membership of KDE e.V. (or its successor appro-
+  ved by the membership of KDE e.V.), which shall act as a proxy
+  defined in Section 14 of version 3 of the license.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program. If not, see http://www.gnu.org/licenses/.
+*/
+
+
+#ifndef METRICS_H
+#define METRICS_H
+
+
+#include <QElapsedTimer>
+#include <QList>
+#include <QMap>
+#include <QObject>
+#include <QSet>
+
+
+class Metrics : public QObject
+{
+    Q_OBJECT
+    Q_CLASSINFO("D-Bus Interface", "org.kde.yakuake")
+
+    public:
+        static Metrics* self();
+
+        void startStartupTimeline(const QElapsedTimer& clock);
+        void finishStartupTimeline();
+        bool isStartingUp() { return m_startingUp; }
+
+        qint64 elapsed() { return m_startupClock.nsecsElapsed(); }
+        void addStartupPhase(const QString& name, qint64 start);
+        const QString startupTimeline();
+
+        void recordPartCreation(int terminalId, qint64 nsecs);
+        void removeTerminal(int terminalId);
+        void recordSparePart(int terminalId) { m_spareTerminals.insert(terminalId); }
+        void recordSpareTaken(int terminalId) { m_spareTerminals.remove(terminalId); }
+        int partCount() { return m_partCreationTimes.count() - m_spareTerminals.count(); }
+        int sparePartCount() { return m_spareTerminals.count(); }
+
+        void recordTerminalPoolHit() { ++m_terminalPoolHits; }
+        void recordTerminalPoolMiss() { ++m_terminalPoolMisses; }
+
+        void recordTabPixmapCacheHit() { ++m_tabPixmapCacheHits; }
+        void recordTabPixmapCacheMiss() { ++m_tabPixmapCacheMisses; }
+
+        void startAnimation();
+        void recordAnimationFrame(qint64 nsecs);
+        void finishAnimation(qint64 nsecs);
+
+        void recordToggleLatency(const QString& backend, qint64 nsecs);
+
+
+    public Q_SLOTS:
+        Q_SCRIPTABLE const QString partCreationTimes();
+        Q_SCRIPTABLE double averagePartCreationTime();
+
+        Q_SCRIPTABLE int terminalPoolHits() { return m_terminalPoolHits; }
+        Q_SCRIPTABLE int terminalPoolMisses() { return m_terminalPoolMisses; }
+
+        Q_SCRIPTABLE int tabPixmapCacheHits() { return m_tabPixmapCacheHits; }
+        Q_SCRIPTABLE int tabPixmapCacheMisses() { return m_tabPixmapCacheMisses; }
+        Q_SCRIPTABLE double tabPixmapCacheHitRate();
+
+        Q_SCRIPTABLE int animationCount() { return m_animationCount; }
+        Q_SCRIPTABLE double lastAnimationDuration() { return m_lastAnimationDuration / 1000000.0; }
+        Q_SCRIPTABLE const QString lastAnimationFrameTimes();
+        Q_SCRIPTABLE double averageAnimationFrameTime();
+        Q_SCRIPTABLE double maximumAnimationFrameTime() { return m_animationFrameMaximum / 1000000.0; }
+
+        Q_SCRIPTABLE const QString toggleLatencyHistogram();
+        Q_SCRIPTABLE double toggleLatencyPercentile(const QString& backend, int percent);
+
+
+    private:
+        explicit Metrics(QObject* parent = 0);
+
+        struct StartupPhase
+        {
+            QString name;
+            qint64 start;
+            qint64 end;
+        };
+
+        QElapsedTimer m_startupClock;
+        QList<StartupPhase> m_startupPhases;
+        bool m_startingUp;
+
+        QMap<int, qint64> m_partCreationTimes;
+        qint64 m_partCreationTotal;
+        int m_partCreationCount;
+
+        // Parts the terminal pool started in the background and no session has taken yet.
+        QSet<int> m_spareTerminals;
+
+        int m_terminalPoolHits;
+        int m_terminalPoolMisses;
+
+        int m_tabPixmapCacheHits;
+        int m_tabPixmapCacheMisses;
+
+        int m_animationCount;
+        qint64 m_lastAnimationDuration;
+        QList<qint64> m_animationFrameTimes;
+        qint64 m_animationFrameTotal;
+        qint64 m_animationFrameMaximum;
+        int m_animationFrameCount;
+
+        // The most recent open latencies per window animation backend.
+        QMap<QString, QList<qint64> > m_toggleLatencies;
+};
+
+#endif
@@ -0,0 +1,137 @@
+/*
+  This program is free software; you can redistribute it and/or
+  modify it under the terms of the GNU General Public License as
+  published by the Free Software Foundation; either version 2 of
+  the License or (at your option) version 3 or any later version
+  accepted by the membership of KDE e.V. (or its successor appro-
+  ved by the membership of KDE e.V.), which shall act as a proxy
+  defined in Section 14 of version 3 of the license.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program. If not, see http://www.gnu.org/licenses/.
+*/
+
+
+
+#include "quickswitcher.h"
+#include "quickswitchindex.h"
+
+#include <KLocalizedString>
+
+#include <QCoreApplication>
+#include <QKeyEvent>
+#include <QLineEdit>
+#include <QListWidget>
+#include <QVBoxLayout>
+
+
+// Enough to fill the popup; the index ranks everything else below these.
+static const int MAXIMUM_RESULTS = 50;
+
+
+QuickSwitcher::QuickSwitcher(QuickSwitchIndex* index, QWidget* parent) : QFrame(parent, Qt::Popup)
+{
+    m_index = index;
+
+    setFrameStyle(QFrame::StyledPanel | QFrame::Raised);
+
+    m_lineEdit = new QLineEdit(this);
+    m_lineEdit->setPlaceholderText(xi18nc("@info:placeholder", "Search tabs, groups and commands"));
+    m_lineEdit->setClearButtonEnabled(true);
+    m_lineEdit->installEventFilter(this);
+
+    m_list = new QListWidget(this);
+    m_list->setUniformItemSizes(true);
+    m_list->setFocusPolicy(Qt::NoFocus);
+
+    QVBoxLayout* layout = new QVBoxLayout(this);
+    layout->setContentsMargins(4, 4, 4, 4);
+    layout->setSpacing(4);
+    layout->addWidget(m_lineEdit);
+    layout->addWidget(m_list);
+
+    connect(m_lineEdit, SIGNAL(textChanged(QString)), this, SLOT(updateResults(QString)));
+    connect(m_lineEdit, SIGNAL(returnPressed()), this, SLOT(choose()));
+    connect(m_list, SIGNAL(itemActivated(QListWidgetItem*)), this, SLOT(choose()));
+}
+
+QuickSwitcher::~QuickSwitcher()
+{
+}
+
+void QuickSwitcher::popup(const QRect& area)
+{
+    int width = qMin(area.width(), qMax(400, area.width() / 2));
+    int height = qMin(area.height(), 320);
+
+    setGeometry(area.x() + (area.width() - width) / 2, area.y(), width, height);
+
+    m_lineEdit->clear();
+    updateResults(QString());
+
+    show();
+    m_lineEdit->setFocus();
+}
+
+void QuickSwitcher::updateResults(const QString& query)
+{
+    m_list->clear();
+
+    foreach (int sessionId, m_index->search(query, MAXIMUM_RESULTS))
+    {
+        QString text = m_index->title(sessionId) + QStringLiteral(" - ") + m_index->group(sessionId);
+
+        if (!m_index->command(sessionId).isEmpty())
+            text += QStringLiteral(" [") + m_index->command(sessionId) + QLatin1Char(']');
+
+        QListWidgetItem* item = new QListWidgetItem(text, m_list);
+        item->setData(Qt::UserRole, sessionId);
+    }
+
+    if (m_list->count()) m_list->setCurrentRow(0);
+}
+
+void QuickSwitcher::choose()
+{
+    QListWidgetItem* item = m_list->currentItem();
+
+    if (!item) return;
+
+    int sessionId = item->data(Qt::UserRole).toInt();
+
+    hide();
+
+    emit sessionChosen(sessionId);
+}
+
+bool QuickSwitcher::eventFilter(QObject* watched, QEvent* event)
+{
+    if (watched == m_lineEdit && event->type() == QEvent::KeyPress)
+    {
+        QKeyEvent* keyEvent = static_cast<QKeyEvent*>(event);
+
+        switch (keyEvent->key())
+        {
+            case Qt::Key_Up:
+            case Qt::Key_Down:
+            case Qt::Key_PageUp:
+            case Qt::Key_PageDown:
+                QCoreApplication::sendEvent(m_list, event);
+                return true;
+
+            case Qt::Key_Escape:
+                hide();
+                return true;
+
+            default:
+                break;
+        }
+    }
+
+    return QFrame::eventFilter(watched, event);
+}
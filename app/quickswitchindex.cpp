@@ -0,0 +1,195 @@
+/*
+  This program is free software; you can redistribute it and/or
+  modify it under the terms of the GNU General Public License as
+  published by the Free Software Foundation; either version 2 of
+  the License or (at your option) version 3 or any later version
+  accepted by the membership of KDE e.V. (or its successor appro-
+  ved by the membership of KDE e.V.), which shall act as a proxy
+  defined in Section 14 of version 3 of the license.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program. If not, see http://www.gnu.org/licenses/.
+*/
+
+
+#include "quickswitchindex.h"
+
+#include <QPair>
+
+#include <algorithm>
+
+
+QuickSwitchIndex::QuickSwitchIndex()
+{
+    m_lastValid = false;
+}
+
+void QuickSwitchIndex::setTab(int sessionId, const QString& title, const QString& group)
+{
+    if (!m_slots.contains(sessionId))
+    {
+        Entry entry;
+        entry.sessionId = sessionId;
+
+        m_slots.insert(sessionId, m_entries.count());
+        m_entries.append(entry);
+    }
+
+    Entry& entry = m_entries[m_slots.value(sessionId)];
+
+    if (entry.title == title && entry.group == group && !entry.foldedTitle.isNull()) return;
+
+    entry.title = title;
+    entry.group = group;
+    entry.foldedTitle = title.toCaseFolded();
+    entry.foldedGroup = group.toCaseFolded();
+
+    changed();
+}
+
+void QuickSwitchIndex::setCommand(int sessionId, const QString& command)
+{
+    if (!m_slots.contains(sessionId)) return;
+
+    Entry& entry = m_entries[m_slots.value(sessionId)];
+
+    if (entry.command == command) return;
+
+    entry.command = command;
+    entry.foldedCommand = command.toCaseFolded();
+
+    changed();
+}
+
+void QuickSwitchIndex::remove(int sessionId)
+{
+    if (!m_slots.contains(sessionId)) return;
+
+    // The last entry takes the place of the removed one.
+    int slot = m_slots.take(sessionId);
+    int last = m_entries.count() - 1;
+
+    if (slot != last)
+    {
+        m_entries[slot] = m_entries.at(last);
+        m_slots.insert(m_entries.at(slot).sessionId, slot);
+    }
+
+    m_entries.removeLast();
+
+    m_lastMatches.removeOne(sessionId);
+}
+
+QString QuickSwitchIndex::title(int sessionId) const
+{
+    if (!m_slots.contains(sessionId)) return QString();
+
+    return m_entries.at(m_slots.value(sessionId)).title;
+}
+
+QString QuickSwitchIndex::group(int sessionId) const
+{
+    if (!m_slots.contains(sessionId)) return QString();
+
+    return m_entries.at(m_slots.value(sessionId)).group;
+}
+
+QString QuickSwitchIndex::command(int sessionId) const
+{
+    if (!m_slots.contains(sessionId)) return QString();
+
+    return m_entries.at(m_slots.value(sessionId)).command;
+}
+
+void QuickSwitchIndex::changed()
+{
+    m_lastValid = false;
+}
+
+int QuickSwitchIndex::match(const QString& haystack, const QString& needle)
+{
+    // Substrings score best, earlier ones better; otherwise the needle has to appear
+    // in order, and the tighter it is packed the better.
+    int position = haystack.indexOf(needle);
+
+    if (position != -1)
+        return 1000 - qMin(position, 500);
+
+    int first = -1;
+    int from = 0;
+
+    for (int index = 0; index < needle.length(); ++index)
+    {
+        from = haystack.indexOf(needle.at(index), from);
+
+        if (from == -1) return 0;
+
+        if (first == -1) first = from;
+
+        ++from;
+    }
+
+    return qMax(1, 500 - (from - first - needle.length()));
+}
+
+int QuickSwitchIndex::score(const Entry& entry, const QString& needle)
+{
+    int titleScore = match(entry.foldedTitle, needle);
+
+    if (titleScore)
+        return titleScore * 2;
+
+    // Each field is matched on its own so that a subsequence can't start in the
+    // group title and end in the command.
+    return qMax(match(entry.foldedGroup, needle), match(entry.foldedCommand, needle));
+}
+
+QList<int> QuickSwitchIndex::search(const QString& query, int limit)
+{
+    QString needle = query.trimmed().toCaseFolded();
+
+    QList<int> candidates;
+
+    if (m_lastValid && !m_lastQuery.isEmpty() && needle.startsWith(m_lastQuery))
+        candidates = m_lastMatches;
+    else
+        candidates = m_slots.keys();
+
+    QList<QPair<int, int> > scored;
+    QList<int> matches;
+
+    foreach (int sessionId, candidates)
+    {
+        const Entry& entry = m_entries.at(m_slots.value(sessionId));
+        int entryScore = needle.isEmpty() ? 1 : score(entry, needle);
+
+        if (entryScore == 0) continue;
+
+        matches << sessionId;
+        scored << qMakePair(-entryScore, sessionId);
+    }
+
+    m_lastQuery = needle;
+    m_lastMatches = matches;
+    m_lastValid = true;
+
+    if (scored.count() > limit)
+    {
+        std::partial_sort(scored.begin(), scored.begin() + limit, scored.end());
+        scored.erase(scored.begin() + limit, scored.end());
+    }
+    else
+        std::sort(scored.begin(), scored.end());
+
+    QList<int> results;
+
+    for (int index = 0; index < scored.count(); ++index)
+        results << scored.at(index).second;
+
+    return results;
+}
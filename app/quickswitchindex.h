@@ -0,0 +1,76 @@
+/*
+  This program is free software; you can redistribute it and/or
+  modify it under the terms of the GNU General Public License as
+  published by the Free Software Foundation; either version 2 of
+  the License or (at your option) version 3 or any later version
+  accepted by the membership of KDE e.V. (or its successor appro-
+  ved by the membership of KDE e.V.), which shall act as a proxy
+  defined in Section 14 of version 3 of the license.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program. If not, see http://www.gnu.org/licenses/.
+*/
+
+
+#ifndef QUICKSWITCHINDEX_H
+#define QUICKSWITCHINDEX_H
+
+
+#include <QHash>
+#include <QList>
+#include <QString>
+#include <QVector>
+
+
+class QuickSwitchIndex
+{
+    public:
+        QuickSwitchIndex();
+
+        void setTab(int sessionId, const QString& title, const QString& group);
+        void setCommand(int sessionId, const QString& command);
+        void remove(int sessionId);
+
+        QList<int> sessionIds() const { return m_slots.keys(); }
+        int count() const { return m_entries.count(); }
+
+        QString title(int sessionId) const;
+        QString group(int sessionId) const;
+        QString command(int sessionId) const;
+
+        QList<int> search(const QString& query, int limit);
+
+
+    private:
+        struct Entry
+        {
+            int sessionId;
+            QString title;
+            QString group;
+            QString command;
+
+            QString foldedTitle;
+            QString foldedGroup;
+            QString foldedCommand;
+        };
+
+        static int match(const QString& haystack, const QString& needle);
+        int score(const Entry& entry, const QString& needle);
+        void changed();
+
+        QVector<Entry> m_entries;
+        QHash<int, int> m_slots;
+
+        // The last query and the sessions it matched; a query that extends it only
+        // needs to look at those.
+        QString m_lastQuery;
+        QList<int> m_lastMatches;
+        bool m_lastValid;
+};
+
+#endif
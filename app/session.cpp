@@ -22,23 +22,30 @@
 
 #include "session.h"
 #include "terminal.h"
+#include "terminalpool.h"
 
 
 int Session::m_availableSessionId = 0;
 
-Session::Session(SessionType type, QWidget* parent) : QObject(parent)
+Session::Session(SessionType type, QWidget* parent, bool deferred, TerminalPool* terminalPool)
+    : QObject(parent)
 {
     m_sessionId = m_availableSessionId;
     m_availableSessionId++;
 
+    m_type = type;
+    m_realized = false;
+
     m_activeTerminalId = -1;
 
     m_closable = true;
 
+    m_terminalPool = terminalPool;
+
     m_baseSplitter = new Splitter(Qt::Horizontal, parent);
     connect(m_baseSplitter, SIGNAL(destroyed()), this, SLOT(prepareShutdown()));
 
-    setupSession(type);
+    if (!deferred) realize();
 }
 
 Session::~Session()
@@ -48,6 +55,26 @@ Session::~Session()
     emit destroyed(m_sessionId);
 }
 
+void Session::realize()
+{
+    if (m_realized) return;
+
+    m_realized = true;
+
+    if (m_layout.isEmpty() || !setupLayout(m_layout))
+        setupSession(m_type);
+
+    emit layoutChanged(m_sessionId);
+}
+
+QString Session::takePendingCommand()
+{
+    QString command = m_pendingCommand;
+    m_pendingCommand.clear();
+
+    return command;
+}
+
 void Session::setupSession(SessionType type)
 {
     switch (type)
@@ -154,9 +181,95 @@ void Session::setupSession(SessionType type)
     }
 }
 
+bool Session::setupLayout(const QString& layout)
+{
+    // Layouts are written by describeSplitter(): "t" is a terminal, "h(...)" and
+    // "v(...)" are splitters listing their children separated by commas.
+    int pos = 0;
+
+    if (!buildLayout(layout, pos, 0) || pos != layout.length())
+        return false;
+
+    pos = 0;
+    buildLayout(layout, pos, m_baseSplitter);
+
+    if (m_terminals.isEmpty()) return false;
+
+    Terminal* terminal = m_terminals.constBegin().value();
+
+    QWidget* terminalWidget = terminal->terminalWidget();
+    if (terminalWidget) terminalWidget->setFocus();
+
+    setActiveTerminal(terminal->id());
+
+    return true;
+}
+
+bool Session::buildLayout(const QString& layout, int& pos, Splitter* parent)
+{
+    if (pos >= layout.length()) return false;
+
+    QChar type = layout.at(pos);
+
+    if (type == QLatin1Char('t'))
+    {
+        ++pos;
+
+        if (parent) addTerminal(parent);
+
+        return true;
+    }
+
+    if (type != QLatin1Char('h') && type != QLatin1Char('v'))
+        return false;
+
+    Qt::Orientation orientation = (type == QLatin1Char('h')) ? Qt::Horizontal : Qt::Vertical;
+    bool root = (pos == 0);
+
+    ++pos;
+
+    if (pos >= layout.length() || layout.at(pos) != QLatin1Char('('))
+        return false;
+
+    ++pos;
+
+    Splitter* splitter = 0;
+
+    if (parent && root)
+    {
+        splitter = parent;
+        splitter->setOrientation(orientation);
+    }
+    else if (parent)
+    {
+        splitter = new Splitter(orientation, parent);
+        connect(splitter, SIGNAL(destroyed()), this, SLOT(cleanup()));
+    }
+
+    forever
+    {
+        if (!buildLayout(layout, pos, splitter)) return false;
+
+        if (pos >= layout.length()) return false;
+
+        if (layout.at(pos) == QLatin1Char(')'))
+        {
+            ++pos;
+
+            return true;
+        }
+
+        if (layout.at(pos) != QLatin1Char(',')) return false;
+
+        ++pos;
+    }
+}
+
 Terminal* Session::addTerminal(QWidget* parent)
 {
-    Terminal* terminal = new Terminal(parent);
+    Terminal* terminal = m_terminalPool ? m_terminalPool->takeTerminal(parent) : 0;
+    if (!terminal) terminal = new Terminal(parent);
+
     connect(terminal, SIGNAL(activated(int)), this, SLOT(setActiveTerminal(int)));
     connect(terminal, SIGNAL(manuallyActivated(Terminal*)), this, SIGNAL(terminalManuallyActivated(Terminal*)));
     connect(terminal, SIGNAL(titleChanged(int,QString)), this, SLOT(setTitle(int,QString)));
@@ -325,6 +438,8 @@ int Session::split(Terminal* terminal, Qt::Orientation orientation)
         m_activeTerminalId = terminal->id();
     }
 
+    emit layoutChanged(m_sessionId);
+
     return m_activeTerminalId;
 }
 
@@ -378,7 +493,7 @@ void Session::setActiveTerminal(int terminalId)
 
 void Session::setTitle(int terminalId, const QString& title)
 {
-    if (terminalId == m_activeTerminalId)
+    if (terminalId == m_activeTerminalId && title != m_title)
     {
         m_title = title;
 
@@ -395,6 +510,8 @@ void Session::cleanup(int terminalId)
     m_terminals.remove(terminalId);
 
     cleanup();
+
+    if (m_terminals.count() > 0) emit layoutChanged(m_sessionId);
 }
 
 void Session::cleanup()
@@ -414,6 +531,50 @@ void Session::prepareShutdown()
     deleteLater();
 }
 
+const QString Session::layoutDescription()
+{
+    if (!m_realized || !m_baseSplitter) return m_layout;
+
+    return describeSplitter(m_baseSplitter);
+}
+
+QString Session::describeSplitter(Splitter* splitter)
+{
+    QStringList children;
+
+    for (int index = 0; index < splitter->count(); ++index)
+    {
+        QWidget* widget = splitter->widget(index);
+        Splitter* childSplitter = qobject_cast<Splitter*>(widget);
+
+        if (childSplitter)
+        {
+            QString child = describeSplitter(childSplitter);
+
+            if (!child.isEmpty()) children << child;
+
+            continue;
+        }
+
+        foreach (Terminal* terminal, m_terminals)
+        {
+            if (terminal->partWidget() == widget)
+            {
+                children << QStringLiteral("t");
+
+                break;
+            }
+        }
+    }
+
+    // Splitters that are about to be cleaned up collapse into their only child.
+    if (children.count() < 2) return children.value(0);
+
+    QString type = (splitter->orientation() == Qt::Horizontal) ? QStringLiteral("h") : QStringLiteral("v");
+
+    return type + QLatin1Char('(') + children.join(QLatin1Char(',')) + QLatin1Char(')');
+}
+
 const QString Session::terminalIdList()
 {
     QList<int> keyList = m_terminals.uniqueKeys();
@@ -521,6 +682,17 @@ bool Session::hasTerminalsWithKeyboardInputDisabled()
     return false;
 }
 
+bool Session::hasForegroundProcesses()
+{
+    QMapIterator<int, Terminal*> i(m_terminals);
+
+    while (i.hasNext())
+        if (i.next().value()->foregroundProcessId() > 0)
+            return true;
+
+    return false;
+}
+
 bool Session::monitorActivityEnabled()
 {
     int monitorActivityEnabledCount = 0;
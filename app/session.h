@@ -31,6 +31,7 @@
 
 
 class Terminal;
+class TerminalPool;
 
 
 class Session : public QObject
@@ -41,13 +42,23 @@ class Session : public QObject
         enum SessionType { Single, TwoHorizontal, TwoVertical, Quad };
         enum GrowthDirection { Up, Right, Down, Left };
 
-        explicit Session(SessionType type = Single, QWidget* parent = 0);
+        explicit Session(SessionType type = Single, QWidget* parent = 0, bool deferred = false,
+            TerminalPool* terminalPool = 0);
          ~Session();
 
         int id() { return m_sessionId; }
         const QString title() { return m_title; }
         QWidget* widget() { return m_baseSplitter; }
 
+        bool isRealized() { return m_realized; }
+        void realize();
+
+        void setPendingCommand(const QString& command) { m_pendingCommand = command; }
+        QString takePendingCommand();
+
+        const QString layoutDescription();
+        void setLayoutDescription(const QString& layout) { m_layout = layout; }
+
         int activeTerminalId() { return m_activeTerminalId; }
         const QString terminalIdList();
         int terminalCount() { return m_terminals.count(); }
@@ -64,6 +75,8 @@ class Session : public QObject
         bool hasTerminalsWithKeyboardInputEnabled();
         bool hasTerminalsWithKeyboardInputDisabled();
 
+        bool hasForegroundProcesses();
+
         bool monitorActivityEnabled();
         void setMonitorActivityEnabled(bool enabled);
         bool monitorActivityEnabled(int terminalId);
@@ -106,6 +119,7 @@ class Session : public QObject
         void activityDetected(Terminal* terminal);
         void silenceDetected(Terminal* terminal);
         void destroyed(int sessionId);
+        void layoutChanged(int sessionId);
 
 
     private Q_SLOTS:
@@ -119,6 +133,9 @@ class Session : public QObject
 
     private:
         void setupSession(SessionType type);
+        bool setupLayout(const QString& layout);
+        bool buildLayout(const QString& layout, int& pos, Splitter* parent);
+        QString describeSplitter(Splitter* splitter);
 
         Terminal* addTerminal(QWidget* parent);
         int split(Terminal* terminal, Qt::Orientation orientation);
@@ -126,8 +143,15 @@ class Session : public QObject
         static int m_availableSessionId;
         int m_sessionId;
 
+        SessionType m_type;
+        bool m_realized;
+        QString m_pendingCommand;
+        QString m_layout;
+
         Splitter* m_baseSplitter;
 
+        TerminalPool* m_terminalPool;
+
         int m_activeTerminalId;
         QMap<int, Terminal*> m_terminals;
 
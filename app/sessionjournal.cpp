@@ -0,0 +1,526 @@
+/*
+  This program is free software; you can redistribute it and/or
+  modify it under the terms of the GNU General Public License as
+  published by the Free Software Foundation; either version 2 of
+  the License or (at your option) version 3 or any later version
+  accepted by the membership of KDE e.V. (or its successor appro-
+  ved by the membership of KDE e.V.), which shall act as a proxy
+  defined in Section 14 of version 3 of the license.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program. If not, see http://www.gnu.org/licenses/.
+*/
+
+
+
+#include "sessionjournal.h"
+#include "sessionjournalwriter.h"
+
+#include <QApplication>
+#include <QDebug>
+#include <QFile>
+#include <QStandardPaths>
+#include <QThread>
+#include <QTimer>
+
+
+// The journal is a text file holding one record per line, each record being a
+// list of percent-encoded fields separated by spaces. Records are folded into
+// m_groups and m_tabs as they are made, so compacting the journal only means
+// writing that model out as a fresh list of records. The file itself is only
+// touched by SessionJournalWriter, on a thread of its own.
+
+static const char journalHeader[] = "yakuake-journal 1";
+static const int flushDelay = 250;
+static const int compactionThreshold = 1000;
+
+static QByteArray encodeRecord(const QStringList& fields)
+{
+    QByteArray line;
+
+    foreach (const QString& field, fields)
+    {
+        if (!line.isEmpty()) line += ' ';
+
+        line += field.toUtf8().toPercentEncoding();
+    }
+
+    return line + '\n';
+}
+
+static QString flag(bool value)
+{
+    return value ? QStringLiteral("1") : QStringLiteral("0");
+}
+
+static bool toIndex(const QString& field, int count, int* index)
+{
+    bool ok = false;
+
+    *index = field.toInt(&ok);
+
+    return ok && *index >= 0 && *index < count;
+}
+
+SessionJournal::SessionJournal(QObject* parent) : QObject(parent)
+{
+    m_path = QStandardPaths::writableLocation(QStandardPaths::AppDataLocation) + QStringLiteral("/session.journal");
+
+    m_recording = false;
+    m_activeGroup = 0;
+    m_recordCount = 0;
+    m_compactPending = false;
+
+    m_writerThread = new QThread(this);
+    m_writer = new SessionJournalWriter(m_path);
+    m_writer->moveToThread(m_writerThread);
+    connect(this, SIGNAL(appendRequested(QByteArray)), m_writer, SLOT(append(QByteArray)));
+    connect(this, SIGNAL(writeRequested(QByteArray)), m_writer, SLOT(write(QByteArray)));
+    connect(this, SIGNAL(removeRequested()), m_writer, SLOT(remove()));
+    connect(m_writerThread, SIGNAL(finished()), m_writer, SLOT(deleteLater()));
+    m_writerThread->start();
+
+    m_flushTimer = new QTimer(this);
+    m_flushTimer->setSingleShot(true);
+    m_flushTimer->setInterval(flushDelay);
+    connect(m_flushTimer, SIGNAL(timeout()), this, SLOT(flush()));
+
+    // Sessions are torn down after the event loop has quit; that must not be recorded.
+    connect(qApp, SIGNAL(aboutToQuit()), this, SLOT(shutdown()));
+}
+
+SessionJournal::~SessionJournal()
+{
+    shutdown();
+}
+
+bool SessionJournal::replay(LayoutConfig::TabsGroupsList& groups, int& activeGroup)
+{
+    QFile file(m_path);
+
+    if (!file.open(QIODevice::ReadOnly)) return false;
+
+    if (file.readLine().trimmed() != journalHeader)
+    {
+        qDebug() << "session journal" << m_path << "has an unknown format, ignoring it";
+
+        return false;
+    }
+
+    m_groups.clear();
+    m_tabs.clear();
+    m_activeGroup = 0;
+
+    while (!file.atEnd())
+    {
+        QByteArray line = file.readLine();
+
+        // A record cut short by a crash has no line end and is dropped.
+        if (!line.endsWith('\n')) break;
+
+        line.chop(1);
+
+        QStringList fields;
+
+        foreach (const QByteArray& field, line.split(' '))
+            fields << QString::fromUtf8(QByteArray::fromPercentEncoding(field));
+
+        apply(fields);
+    }
+
+    groups.clear();
+
+    foreach (const Group& group, m_groups)
+    {
+        LayoutConfig::TabsGroup tabsGroup(group.title);
+        tabsGroup.locked = group.locked;
+        tabsGroup.from_layout = group.fromLayout;
+        tabsGroup.selected_tab = qMax(0, group.tabs.indexOf(group.selectedSessionId));
+
+        foreach (int sessionId, group.tabs)
+        {
+            const Tab tab = m_tabs.value(sessionId);
+
+            LayoutConfig::Tab layoutTab(tab.title.isEmpty() ? QStringLiteral("auto") : tab.title);
+            layoutTab.closable = tab.closable;
+            layoutTab.layout = tab.layout;
+            layoutTab.origin = tab.origin;
+
+            tabsGroup.tabs.append(layoutTab);
+        }
+
+        groups.append(tabsGroup);
+    }
+
+    activeGroup = qBound(0, m_activeGroup, groups.count() - 1);
+
+    return !groups.isEmpty();
+}
+
+void SessionJournal::reset(const QList<Group>& groups, const QHash<int, Tab>& tabs, int activeGroup)
+{
+    m_groups = groups;
+    m_tabs = tabs;
+    m_activeGroup = activeGroup;
+
+    m_recording = true;
+
+    // The journal has to be rewritten for the new session ids, but that can wait
+    // for the first flush rather than hold up the first paint.
+    m_pending.clear();
+    m_compactPending = true;
+
+    if (!m_flushTimer->isActive()) m_flushTimer->start();
+}
+
+void SessionJournal::clear()
+{
+    m_recording = false;
+
+    m_flushTimer->stop();
+    m_pending.clear();
+    m_recordCount = 0;
+    m_compactPending = false;
+
+    m_groups.clear();
+    m_tabs.clear();
+    m_activeGroup = 0;
+
+    emit removeRequested();
+}
+
+void SessionJournal::addGroup(const QString& title, bool locked)
+{
+    record(QStringList() << QStringLiteral("group-add") << title << flag(locked));
+}
+
+void SessionJournal::removeGroup(int index)
+{
+    record(QStringList() << QStringLiteral("group-remove") << QString::number(index));
+}
+
+void SessionJournal::moveGroup(int from, int to)
+{
+    record(QStringList() << QStringLiteral("group-move") << QString::number(from) << QString::number(to));
+}
+
+void SessionJournal::setGroupTitle(int index, const QString& title)
+{
+    record(QStringList() << QStringLiteral("group-title") << QString::number(index) << title);
+}
+
+void SessionJournal::setGroupLocked(int index, bool locked)
+{
+    record(QStringList() << QStringLiteral("group-lock") << QString::number(index) << flag(locked));
+}
+
+void SessionJournal::setGroupFromLayout(int index, bool fromLayout)
+{
+    if (index >= 0 && index < m_groups.count() && m_groups.at(index).fromLayout == fromLayout) return;
+
+    record(QStringList() << QStringLiteral("group-origin") << QString::number(index) << flag(fromLayout));
+}
+
+void SessionJournal::selectGroup(int index)
+{
+    if (index == m_activeGroup) return;
+
+    record(QStringList() << QStringLiteral("group-select") << QString::number(index));
+}
+
+void SessionJournal::addTab(int group, int sessionId)
+{
+    record(QStringList() << QStringLiteral("tab-add") << QString::number(group) << QString::number(sessionId));
+}
+
+void SessionJournal::removeTab(int sessionId)
+{
+    record(QStringList() << QStringLiteral("tab-remove") << QString::number(sessionId));
+}
+
+void SessionJournal::moveTab(int sessionId, int group, int index)
+{
+    record(QStringList() << QStringLiteral("tab-move") << QString::number(sessionId)
+        << QString::number(group) << QString::number(index));
+}
+
+void SessionJournal::setTabTitle(int sessionId, const QString& title)
+{
+    record(QStringList() << QStringLiteral("tab-title") << QString::number(sessionId) << title);
+}
+
+void SessionJournal::setTabOrigin(int sessionId, const QString& origin)
+{
+    if (m_tabs.value(sessionId).origin == origin) return;
+
+    record(QStringList() << QStringLiteral("tab-origin") << QString::number(sessionId) << origin);
+}
+
+void SessionJournal::selectTab(int sessionId)
+{
+    int group = groupOf(sessionId);
+
+    if (group != -1 && m_groups.at(group).selectedSessionId == sessionId) return;
+
+    record(QStringList() << QStringLiteral("tab-select") << QString::number(sessionId));
+}
+
+void SessionJournal::setTabClosable(int sessionId, bool closable)
+{
+    record(QStringList() << QStringLiteral("tab-closable") << QString::number(sessionId) << flag(closable));
+}
+
+void SessionJournal::setTabLayout(int sessionId, const QString& layout)
+{
+    if (m_tabs.value(sessionId).layout == layout) return;
+
+    record(QStringList() << QStringLiteral("tab-layout") << QString::number(sessionId) << layout);
+}
+
+void SessionJournal::flush()
+{
+    m_flushTimer->stop();
+
+    if (m_compactPending || m_recordCount >= compactionThreshold)
+    {
+        compact();
+
+        return;
+    }
+
+    if (m_pending.isEmpty()) return;
+
+    emit appendRequested(m_pending);
+    m_pending.clear();
+}
+
+void SessionJournal::shutdown()
+{
+    if (!m_writerThread->isRunning()) return;
+
+    flush();
+
+    m_recording = false;
+
+    // Writes still queued for the writer are done before the thread stops.
+    m_writerThread->quit();
+    m_writerThread->wait();
+}
+
+void SessionJournal::record(const QStringList& fields)
+{
+    if (!m_recording) return;
+
+    // Records the model cannot fold would make the journal unreplayable.
+    if (!apply(fields)) return;
+
+    m_pending += encodeRecord(fields);
+    ++m_recordCount;
+
+    if (!m_flushTimer->isActive()) m_flushTimer->start();
+}
+
+bool SessionJournal::apply(const QStringList& fields)
+{
+    const QString type = fields.value(0);
+    int count = fields.count();
+    int index, target, sessionId;
+    bool ok;
+
+    if (type == QLatin1String("group-add") && count == 3)
+    {
+        Group group;
+        group.title = fields.at(1);
+        group.locked = (fields.at(2) == flag(true));
+
+        m_groups.append(group);
+    }
+    else if (type == QLatin1String("group-remove") && count == 2)
+    {
+        if (!toIndex(fields.at(1), m_groups.count(), &index)) return false;
+
+        foreach (int id, m_groups.at(index).tabs)
+            m_tabs.remove(id);
+
+        m_groups.removeAt(index);
+
+        if (index < m_activeGroup) --m_activeGroup;
+        if (m_activeGroup >= m_groups.count()) m_activeGroup = qMax(0, m_groups.count() - 1);
+    }
+    else if (type == QLatin1String("group-move") && count == 3)
+    {
+        if (!toIndex(fields.at(1), m_groups.count(), &index)) return false;
+        if (!toIndex(fields.at(2), m_groups.count(), &target)) return false;
+
+        m_groups.move(index, target);
+
+        if (m_activeGroup == index)
+            m_activeGroup = target;
+        else if (index < m_activeGroup && target >= m_activeGroup)
+            --m_activeGroup;
+        else if (index > m_activeGroup && target <= m_activeGroup)
+            ++m_activeGroup;
+    }
+    else if (type == QLatin1String("group-title") && count == 3)
+    {
+        if (!toIndex(fields.at(1), m_groups.count(), &index)) return false;
+
+        m_groups[index].title = fields.at(2);
+    }
+    else if (type == QLatin1String("group-lock") && count == 3)
+    {
+        if (!toIndex(fields.at(1), m_groups.count(), &index)) return false;
+
+        m_groups[index].locked = (fields.at(2) == flag(true));
+    }
+    else if (type == QLatin1String("group-origin") && count == 3)
+    {
+        if (!toIndex(fields.at(1), m_groups.count(), &index)) return false;
+
+        m_groups[index].fromLayout = (fields.at(2) == flag(true));
+    }
+    else if (type == QLatin1String("group-select") && count == 2)
+    {
+        if (!toIndex(fields.at(1), m_groups.count(), &index)) return false;
+
+        m_activeGroup = index;
+    }
+    else if (type == QLatin1String("tab-add") && count == 3)
+    {
+        if (!toIndex(fields.at(1), m_groups.count(), &index)) return false;
+
+        sessionId = fields.at(2).toInt(&ok);
+        if (!ok || groupOf(sessionId) != -1) return false;
+
+        m_groups[index].tabs.append(sessionId);
+
+        // Layout records may arrive before the tab itself is added.
+        if (!m_tabs.contains(sessionId)) m_tabs.insert(sessionId, Tab());
+    }
+    else if (type == QLatin1String("tab-remove") && count == 2)
+    {
+        sessionId = fields.at(1).toInt(&ok);
+        if (!ok) return false;
+
+        index = groupOf(sessionId);
+        if (index != -1) m_groups[index].tabs.removeOne(sessionId);
+
+        m_tabs.remove(sessionId);
+    }
+    else if (type == QLatin1String("tab-move") && count == 4)
+    {
+        sessionId = fields.at(1).toInt(&ok);
+        if (!ok) return false;
+
+        index = groupOf(sessionId);
+        if (index == -1) return false;
+        if (!toIndex(fields.at(2), m_groups.count(), &target)) return false;
+
+        int position = fields.at(3).toInt(&ok);
+        if (!ok) return false;
+
+        m_groups[index].tabs.removeOne(sessionId);
+
+        QList<int>& tabs = m_groups[target].tabs;
+        tabs.insert(qBound(0, position, tabs.count()), sessionId);
+    }
+    else if (type == QLatin1String("tab-select") && count == 2)
+    {
+        sessionId = fields.at(1).toInt(&ok);
+        if (!ok) return false;
+
+        index = groupOf(sessionId);
+        if (index == -1) return false;
+
+        m_groups[index].selectedSessionId = sessionId;
+    }
+    else if ((type == QLatin1String("tab-title") || type == QLatin1String("tab-closable")
+        || type == QLatin1String("tab-layout") || type == QLatin1String("tab-origin")) && count == 3)
+    {
+        sessionId = fields.at(1).toInt(&ok);
+        if (!ok) return false;
+
+        Tab& tab = m_tabs[sessionId];
+
+        if (type == QLatin1String("tab-title"))
+            tab.title = fields.at(2);
+        else if (type == QLatin1String("tab-closable"))
+            tab.closable = (fields.at(2) == flag(true));
+        else if (type == QLatin1String("tab-origin"))
+            tab.origin = fields.at(2);
+        else
+            tab.layout = fields.at(2);
+    }
+    else
+        return false;
+
+    return true;
+}
+
+void SessionJournal::compact()
+{
+    QList<QStringList> records;
+
+    for (int index = 0; index < m_groups.count(); ++index)
+    {
+        const Group& group = m_groups.at(index);
+
+        records << (QStringList() << QStringLiteral("group-add") << group.title << flag(group.locked));
+
+        if (group.fromLayout)
+            records << (QStringList() << QStringLiteral("group-origin") << QString::number(index) << flag(true));
+
+        foreach (int sessionId, group.tabs)
+        {
+            const Tab tab = m_tabs.value(sessionId);
+
+            records << (QStringList() << QStringLiteral("tab-add") << QString::number(index) << QString::number(sessionId));
+
+            if (!tab.title.isEmpty())
+                records << (QStringList() << QStringLiteral("tab-title") << QString::number(sessionId) << tab.title);
+
+            if (!tab.closable)
+                records << (QStringList() << QStringLiteral("tab-closable") << QString::number(sessionId) << flag(false));
+
+            if (!tab.layout.isEmpty())
+                records << (QStringList() << QStringLiteral("tab-layout") << QString::number(sessionId) << tab.layout);
+
+            if (!tab.origin.isEmpty())
+                records << (QStringList() << QStringLiteral("tab-origin") << QString::number(sessionId) << tab.origin);
+        }
+
+        if (group.tabs.contains(group.selectedSessionId))
+            records << (QStringList() << QStringLiteral("tab-select") << QString::number(group.selectedSessionId));
+    }
+
+    records << (QStringList() << QStringLiteral("group-select") << QString::number(m_activeGroup));
+
+    m_flushTimer->stop();
+    m_pending.clear();
+    m_recordCount = 0;
+    m_compactPending = false;
+
+    QByteArray journal(journalHeader);
+    journal += '\n';
+
+    foreach (const QStringList& record, records)
+        journal += encodeRecord(record);
+
+    emit writeRequested(journal);
+}
+
+int SessionJournal::groupOf(int sessionId)
+{
+    for (int index = 0; index < m_groups.count(); ++index)
+    {
+        if (m_groups.at(index).tabs.contains(sessionId))
+            return index;
+    }
+
+    return -1;
+}
@@ -0,0 +1,131 @@
+/*
+  This program is free software; you can redistribute it and/or
+  modify it under the terms of the GNU General Public License as
+  published by the Free Software Foundation; either version 2 of
+  the License or (at your option) version 3 or any later version
+  accepted by the membership of KDE e.V. (or its successor appro-
+  ved by the membership of KDE e.V.), which shall act as a proxy
+  defined in Section 14 of version 3 of the license.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program. If not, see http://www.gnu.org/licenses/.
+*/
+
+
+
+#ifndef SESSIONJOURNAL_H
+#define SESSIONJOURNAL_H
+
+
+#include "layoutconfig.h"
+
+#include <QByteArray>
+#include <QHash>
+#include <QList>
+#include <QObject>
+#include <QStringList>
+
+
+class SessionJournalWriter;
+
+class QThread;
+class QTimer;
+
+
+class SessionJournal : public QObject
+{
+    Q_OBJECT
+
+    public:
+        struct Tab
+        {
+            QString title;
+            bool closable;
+            QString layout;
+            QString origin;
+
+            Tab() : closable(true) {}
+        };
+
+        struct Group
+        {
+            QString title;
+            bool locked;
+            bool fromLayout;
+            int selectedSessionId;
+            QList<int> tabs;
+
+            Group() : locked(false), fromLayout(false), selectedSessionId(-1) {}
+        };
+
+        explicit SessionJournal(QObject* parent = 0);
+         ~SessionJournal();
+
+        bool isRecording() { return m_recording; }
+
+        bool replay(LayoutConfig::TabsGroupsList& groups, int& activeGroup);
+        void reset(const QList<Group>& groups, const QHash<int, Tab>& tabs, int activeGroup);
+        void clear();
+
+        void addGroup(const QString& title, bool locked);
+        void removeGroup(int index);
+        void moveGroup(int from, int to);
+        void setGroupTitle(int index, const QString& title);
+        void setGroupLocked(int index, bool locked);
+        void setGroupFromLayout(int index, bool fromLayout);
+        void selectGroup(int index);
+
+        void addTab(int group, int sessionId);
+        void removeTab(int sessionId);
+        void moveTab(int sessionId, int group, int index);
+        void setTabTitle(int sessionId, const QString& title);
+        void setTabOrigin(int sessionId, const QString& origin);
+        void selectTab(int sessionId);
+
+
+    public Q_SLOTS:
+        void setTabClosable(int sessionId, bool closable);
+        void setTabLayout(int sessionId, const QString& layout);
+
+        void flush();
+        void shutdown();
+
+
+    Q_SIGNALS:
+        void appendRequested(const QByteArray& records);
+        void writeRequested(const QByteArray& journal);
+        void removeRequested();
+
+
+    private:
+        void record(const QStringList& fields);
+        bool apply(const QStringList& fields);
+        void compact();
+
+        int groupOf(int sessionId);
+
+        QString m_path;
+
+        bool m_recording;
+
+        QList<Group> m_groups;
+        QHash<int, Tab> m_tabs;
+        int m_activeGroup;
+
+        QByteArray m_pending;
+        int m_recordCount;
+        bool m_compactPending;
+
+        QTimer* m_flushTimer;
+
+        // Journal files are written on their own thread; the GUI thread only encodes records.
+        QThread* m_writerThread;
+        SessionJournalWriter* m_writer;
+};
+
+#endif
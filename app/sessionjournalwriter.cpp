@@ -0,0 +1,75 @@
+/*
+  This program is free software; you can redistribute it and/or
+  modify it under the terms of the GNU General Public License as
+  published by the Free Software Foundation; either version 2 of
+  the License or (at your option) version 3 or any later version
+  accepted by the membership of KDE e.V. (or its successor appro-
+  ved by the membership of KDE e.V.), which shall act as a proxy
+  defined in Section 14 of version 3 of the license.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program. If not, see http://www.gnu.org/licenses/.
+*/
+
+
+
+#include "sessionjournalwriter.h"
+
+#include <QDebug>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QSaveFile>
+
+
+SessionJournalWriter::SessionJournalWriter(const QString& path, QObject* parent) : QObject(parent)
+{
+    m_path = path;
+}
+
+SessionJournalWriter::~SessionJournalWriter()
+{
+}
+
+void SessionJournalWriter::append(const QByteArray& records)
+{
+    QFile file(m_path);
+
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Append))
+    {
+        qDebug() << "failed to write session journal" << m_path;
+
+        return;
+    }
+
+    file.write(records);
+}
+
+void SessionJournalWriter::write(const QByteArray& journal)
+{
+    QDir().mkpath(QFileInfo(m_path).absolutePath());
+
+    QSaveFile file(m_path);
+
+    if (!file.open(QIODevice::WriteOnly))
+    {
+        qDebug() << "failed to write session journal" << m_path;
+
+        return;
+    }
+
+    file.write(journal);
+
+    if (!file.commit())
+        qDebug() << "failed to write session journal" << m_path;
+}
+
+void SessionJournalWriter::remove()
+{
+    QFile::remove(m_path);
+}
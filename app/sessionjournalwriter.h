@@ -0,0 +1,49 @@
+/*
+  This program is free software; you can redistribute it and/or
+  modify it under the terms of the GNU General Public License as
+  published by the Free Software Foundation; either version 2 of
+  the License or (at your option) version 3 or any later version
+  accepted by the membership of KDE e.V. (or its successor appro-
+  ved by the membership of KDE e.V.), which shall act as a proxy
+  defined in Section 14 of version 3 of the license.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program. If not, see http://www.gnu.org/licenses/.
+*/
+
+
+
+#ifndef SESSIONJOURNALWRITER_H
+#define SESSIONJOURNALWRITER_H
+
+
+#include <QByteArray>
+#include <QObject>
+#include <QString>
+
+
+class SessionJournalWriter : public QObject
+{
+    Q_OBJECT
+
+    public:
+        explicit SessionJournalWriter(const QString& path, QObject* parent = 0);
+         ~SessionJournalWriter();
+
+
+    public Q_SLOTS:
+        void append(const QByteArray& records);
+        void write(const QByteArray& journal);
+        void remove();
+
+
+    private:
+        QString m_path;
+};
+
+#endif
@@ -21,8 +21,11 @@
 
 
 #include "sessionstack.h"
+#include "commandscheduler.h"
 #include "settings.h"
 #include "terminal.h"
+#include "terminalpool.h"
+#include "titlecoalescer.h"
 #include "visualeventoverlay.h"
 
 #include "config-yakuake.h"
@@ -43,6 +46,12 @@ SessionStack::SessionStack(QWidget* parent) : QStackedWidget(parent)
 
     m_visualEventOverlay = new VisualEventOverlay(this);
     connect(this, SIGNAL(removeTerminalHighlight()), m_visualEventOverlay, SLOT(removeTerminalHighlight()));
+
+    m_terminalPool = new TerminalPool(this);
+    m_commandScheduler = new CommandScheduler(this);
+
+    m_titleCoalescer = new TitleCoalescer(this);
+    connect(m_titleCoalescer, SIGNAL(titleChanged(int,QString)), this, SLOT(handleTitleChange(int,QString)));
 }
 
 SessionStack::~SessionStack()
@@ -51,24 +60,36 @@ SessionStack::~SessionStack()
 
 int SessionStack::addSession(Session::SessionType type)
 {
-    Session* session = new Session(type, this);
-    connect(session, SIGNAL(titleChanged(int,QString)), this, SIGNAL(titleChanged(int,QString)));
+    return addSession(type, false);
+}
+
+int SessionStack::addSession(Session::SessionType type, bool deferred, const QString& command, const QString& layout)
+{
+    Session* session = new Session(type, this, true, m_terminalPool);
+    session->setPendingCommand(command);
+    session->setLayoutDescription(layout);
+    connect(session, SIGNAL(titleChanged(int,QString)), m_titleCoalescer, SLOT(setTitle(int,QString)));
     connect(session, SIGNAL(terminalManuallyActivated(Terminal*)), this, SLOT(handleManualTerminalActivation(Terminal*)));
     connect(session, SIGNAL(keyboardInputBlocked(Terminal*)), m_visualEventOverlay, SLOT(indicateKeyboardInputBlocked(Terminal*)));
     connect(session, SIGNAL(activityDetected(Terminal*)), parentWidget(), SLOT(handleTerminalActivity(Terminal*)));
     connect(session, SIGNAL(silenceDetected(Terminal*)), parentWidget(), SLOT(handleTerminalSilence(Terminal*)));
     connect(parentWidget(), SIGNAL(windowClosed()), session, SLOT(reconnectMonitorActivitySignals()));
     connect(session, SIGNAL(destroyed(int)), this, SLOT(cleanup(int)));
+    connect(session, SIGNAL(layoutChanged(int)), this, SLOT(handleLayoutChange(int)));
 
     addWidget(session->widget());
 
     m_sessions.insert(session->id(), session);
 
+    if (!deferred) session->realize();
+
     if (Settings::dynamicTabTitles())
         emit sessionAdded(session->id(), session->title());
     else
         emit sessionAdded(session->id(), QString());
 
+    if (!deferred) realizeSession(session);
+
     return session->id();
 }
 
@@ -87,11 +108,76 @@ int SessionStack::addSessionQuad()
     return addSession(Session::Quad);
 }
 
+bool SessionStack::isSessionRealized(int sessionId)
+{
+    if (!m_sessions.contains(sessionId)) return false;
+
+    return m_sessions.value(sessionId)->isRealized();
+}
+
+const QString SessionStack::sessionLayout(int sessionId)
+{
+    if (!m_sessions.contains(sessionId)) return QString();
+
+    return m_sessions.value(sessionId)->layoutDescription();
+}
+
+QWidget* SessionStack::activeTerminalWidget()
+{
+    if (!m_sessions.contains(m_activeSessionId)) return 0;
+
+    Session* session = m_sessions.value(m_activeSessionId);
+
+    if (!session->isRealized()) return 0;
+
+    Terminal* terminal = session->getTerminal(session->activeTerminalId());
+
+    return terminal ? terminal->terminalWidget() : 0;
+}
+
+QString SessionStack::foregroundProcessName(int sessionId)
+{
+    if (!m_sessions.contains(sessionId)) return QString();
+
+    Session* session = m_sessions.value(sessionId);
+
+    // Placeholders have no terminal to ask yet.
+    if (!session->isRealized()) return QString();
+
+    Terminal* terminal = session->getTerminal(session->activeTerminalId());
+
+    return terminal ? terminal->foregroundProcessName() : QString();
+}
+
+void SessionStack::handleLayoutChange(int sessionId)
+{
+    emit sessionLayoutChanged(sessionId, sessionLayout(sessionId));
+}
+
+void SessionStack::realizeSession(int sessionId)
+{
+    if (!m_sessions.contains(sessionId)) return;
+
+    realizeSession(m_sessions.value(sessionId));
+}
+
+void SessionStack::realizeSession(Session* session)
+{
+    if (!session->isRealized()) session->realize();
+
+    QString command = session->takePendingCommand();
+
+    if (!command.isEmpty())
+        m_commandScheduler->enqueue(session->getTerminal(session->activeTerminalId()), command);
+}
+
 void SessionStack::raiseSession(int sessionId)
 {
     if (sessionId == -1 || !m_sessions.contains(sessionId)) return;
     Session* session = m_sessions.value(sessionId);
 
+    realizeSession(session);
+
     if (!m_visualEventOverlay->isHidden())
         m_visualEventOverlay->hide();
 
@@ -103,8 +189,6 @@ void SessionStack::raiseSession(int sessionId)
         disconnect(oldActiveSession, SLOT(focusPreviousTerminal()));
         disconnect(oldActiveSession, SLOT(focusNextTerminal()));
         disconnect(oldActiveSession, SLOT(manageProfiles()));
-        disconnect(oldActiveSession, SIGNAL(titleChanged(QString)),
-            this, SIGNAL(activeTitleChanged(QString)));
 
         oldActiveSession->reconnectMonitorActivitySignals();
     }
@@ -123,7 +207,6 @@ void SessionStack::raiseSession(int sessionId)
     connect(this, SIGNAL(previousTerminal()), session, SLOT(focusPreviousTerminal()));
     connect(this, SIGNAL(nextTerminal()), session, SLOT(focusNextTerminal()));
     connect(this, SIGNAL(manageProfiles()), session, SLOT(manageProfiles()));
-    connect(session, SIGNAL(titleChanged(QString)), this, SIGNAL(activeTitleChanged(QString)));
 
     emit sessionRaised(sessionId);
 
@@ -140,6 +223,21 @@ void SessionStack::removeSession(int sessionId)
         m_sessions.value(sessionId)->deleteLater();
 }
 
+bool SessionStack::discardSession(int sessionId)
+{
+    if (!m_sessions.contains(sessionId)) return false;
+
+    Session* session = m_sessions.value(sessionId);
+
+    // Never asks: locked sessions and ones running a program are left alone instead.
+    if (!session->closable() || (session->isRealized() && session->hasForegroundProcesses()))
+        return false;
+
+    session->deleteLater();
+
+    return true;
+}
+
 void SessionStack::removeTerminal(int terminalId)
 {
     int sessionId = sessionIdForTerminalId(terminalId);
@@ -175,10 +273,19 @@ void SessionStack::cleanup(int sessionId)
     if (sessionId == m_activeSessionId) m_activeSessionId = -1;
 
     m_sessions.remove(sessionId);
+    m_titleCoalescer->remove(sessionId);
 
     emit sessionRemoved(sessionId);
 }
 
+void SessionStack::handleTitleChange(int sessionId, const QString& title)
+{
+    emit titleChanged(sessionId, title);
+
+    if (sessionId == m_activeSessionId)
+        emit activeTitleChanged(title);
+}
+
 int SessionStack::activeTerminalId()
 {
     if (!m_sessions.contains(m_activeSessionId)) return -1;
@@ -209,6 +316,8 @@ const QString SessionStack::terminalIdList()
     {
         it.next();
 
+        realizeSession(it.value());
+
         idList << it.value()->terminalIdList();
     }
 
@@ -219,6 +328,8 @@ const QString SessionStack::terminalIdsForSessionId(int sessionId)
 {
     if (!m_sessions.contains(sessionId)) return QString::number(-1);
 
+    realizeSession(m_sessions.value(sessionId));
+
     return m_sessions.value(sessionId)->terminalIdList();
 }
 
@@ -294,6 +405,8 @@ void SessionStack::setSessionClosable(int sessionId, bool closable)
     if (!m_sessions.contains(sessionId)) return;
 
     m_sessions.value(sessionId)->setClosable(closable);
+
+    emit sessionClosableChanged(sessionId, closable);
 }
 
 bool SessionStack::hasUnclosableSessions() const
@@ -503,6 +616,8 @@ int SessionStack::splitSessionLeftRight(int sessionId)
     if (sessionId == -1) return -1;
     if (!m_sessions.contains(sessionId)) return -1;
 
+    realizeSession(m_sessions.value(sessionId));
+
     return m_sessions.value(sessionId)->splitLeftRight();
 }
 
@@ -511,6 +626,8 @@ int SessionStack::splitSessionTopBottom(int sessionId)
     if (sessionId == -1) return -1;
     if (!m_sessions.contains(sessionId)) return -1;
 
+    realizeSession(m_sessions.value(sessionId));
+
     return m_sessions.value(sessionId)->splitTopBottom();
 }
 
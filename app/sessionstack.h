@@ -32,7 +32,10 @@
 #include <QStackedWidget>
 
 
+class CommandScheduler;
+class TitleCoalescer;
 class Session;
+class TerminalPool;
 class VisualEventOverlay;
 
 class SessionStack : public QStackedWidget
@@ -44,7 +47,16 @@ class SessionStack : public QStackedWidget
         explicit SessionStack(QWidget* parent = 0);
         ~SessionStack();
 
+        int addSession(Session::SessionType type, bool deferred, const QString& command = QString(),
+            const QString& layout = QString());
+        bool isSessionRealized(int sessionId);
+        void realizeSession(int sessionId);
+        const QString sessionLayout(int sessionId);
+        QString foregroundProcessName(int sessionId);
+        QWidget* activeTerminalWidget();
+
         void closeActiveTerminal(int sessionId = -1);
+        bool discardSession(int sessionId);
 
         void editProfile(int sessionId = -1);
 
@@ -52,6 +64,9 @@ class SessionStack : public QStackedWidget
 
         bool requiresVisualEventOverlay();
 
+        TerminalPool* terminalPool() { return m_terminalPool; }
+        CommandScheduler* commandScheduler() { return m_commandScheduler; }
+
 
     public Q_SLOTS:
         Q_SCRIPTABLE int addSession(Session::SessionType type = Session::Single);
@@ -122,6 +137,8 @@ class SessionStack : public QStackedWidget
         void sessionAdded(int sessionId, const QString& title);
         void sessionRaised(int sessionId);
         void sessionRemoved(int sessionId);
+        void sessionClosableChanged(int sessionId, bool closable);
+        void sessionLayoutChanged(int sessionId, const QString& layout);
 
         void activeTitleChanged(const QString& title);
         void titleChanged(int sessionId, const QString& title);
@@ -142,6 +159,8 @@ class SessionStack : public QStackedWidget
 
     private Q_SLOTS:
         void handleManualTerminalActivation(Terminal*);
+        void handleLayoutChange(int sessionId);
+        void handleTitleChange(int sessionId, const QString& title);
 
         void cleanup(int sessionId);
 
@@ -150,8 +169,14 @@ class SessionStack : public QStackedWidget
         enum QueryCloseType { QueryCloseSession, QueryCloseTerminal };
         bool queryClose(int sessionId, QueryCloseType type);
 
+        void realizeSession(Session* session);
+
         VisualEventOverlay* m_visualEventOverlay;
 
+        TerminalPool* m_terminalPool;
+        CommandScheduler* m_commandScheduler;
+        TitleCoalescer* m_titleCoalescer;
+
         int m_activeSessionId;
 
         QHash<int, Session*> m_sessions;
@@ -25,13 +25,23 @@
 #include <KConfigGroup>
 #include <KIconLoader>
 
+#include <QBitmap>
+#include <QCryptographicHash>
+#include <QDateTime>
+#include <QDir>
 #include <QFileInfo>
 #include <QIcon>
+#include <QImageReader>
+#include <QPainter>
+#include <QStandardPaths>
+#include <QSvgRenderer>
 
 
 Skin::Skin()
 {
     m_borderWidth = 0;
+    m_devicePixelRatio = 1.0;
+    m_titleBarMaskWidth = -1;
 }
 
 Skin::~Skin()
@@ -57,6 +67,9 @@ bool Skin::load(const QString& name, bool kns)
     KConfig titleConfig(titlePath, KConfig::SimpleConfig);
     KConfig tabConfig(tabPath, KConfig::SimpleConfig);
 
+    m_images.clear();
+    m_renderCache.clear();
+
 
     KConfigGroup border = titleConfig.group("Border");
 
@@ -69,9 +82,9 @@ bool Skin::load(const QString& name, bool kns)
 
     KConfigGroup titleBarBackground = titleConfig.group("Background");
 
-    m_titleBarBackgroundImage.load(titleDir + titleBarBackground.readEntry("back_image", ""));
-    m_titleBarLeftCornerImage.load(titleDir + titleBarBackground.readEntry("left_corner", ""));
-    m_titleBarRightCornerImage.load(titleDir + titleBarBackground.readEntry("right_corner", ""));
+    loadImage(m_titleBarBackgroundImage, titleDir + titleBarBackground.readEntry("back_image", ""));
+    loadImage(m_titleBarLeftCornerImage, titleDir + titleBarBackground.readEntry("left_corner", ""));
+    loadImage(m_titleBarRightCornerImage, titleDir + titleBarBackground.readEntry("right_corner", ""));
 
 
     KConfigGroup titleBarFocusButton = titleConfig.group("FocusButton");
@@ -79,9 +92,7 @@ bool Skin::load(const QString& name, bool kns)
     m_titleBarFocusButtonPosition.setX(titleBarFocusButton.readEntry("x", 0));
     m_titleBarFocusButtonPosition.setY(titleBarFocusButton.readEntry("y", 0));
 
-    m_titleBarFocusButtonStyleSheet = buttonStyleSheet(titleDir + titleBarFocusButton.readEntry("up_image", ""),
-                                                       titleDir + titleBarFocusButton.readEntry("over_image", ""),
-                                                       titleDir + titleBarFocusButton.readEntry("down_image", ""));
+    loadButtonImages(m_titleBarFocusButtonImages, titleDir, titleBarFocusButton);
 
 
     KConfigGroup titleBarMenuButton = titleConfig.group("ConfigButton");
@@ -89,9 +100,7 @@ bool Skin::load(const QString& name, bool kns)
     m_titleBarMenuButtonPosition.setX(titleBarMenuButton.readEntry("x", 0));
     m_titleBarMenuButtonPosition.setY(titleBarMenuButton.readEntry("y", 0));
 
-    m_titleBarMenuButtonStyleSheet = buttonStyleSheet(titleDir + titleBarMenuButton.readEntry("up_image", ""),
-                                                        titleDir + titleBarMenuButton.readEntry("over_image", ""),
-                                                        titleDir + titleBarMenuButton.readEntry("down_image", ""));
+    loadButtonImages(m_titleBarMenuButtonImages, titleDir, titleBarMenuButton);
 
 
     KConfigGroup titleBarQuitButton = titleConfig.group("QuitButton");
@@ -99,9 +108,7 @@ bool Skin::load(const QString& name, bool kns)
     m_titleBarQuitButtonPosition.setX(titleBarQuitButton.readEntry("x", 0));
     m_titleBarQuitButtonPosition.setY(titleBarQuitButton.readEntry("y", 0));
 
-    m_titleBarQuitButtonStyleSheet = buttonStyleSheet(titleDir + titleBarQuitButton.readEntry("up_image", ""),
-                                                      titleDir + titleBarQuitButton.readEntry("over_image", ""),
-                                                      titleDir + titleBarQuitButton.readEntry("down_image", ""));
+    loadButtonImages(m_titleBarQuitButtonImages, titleDir, titleBarQuitButton);
 
 
     KConfigGroup titleBarText = titleConfig.group("Text");
@@ -127,24 +134,24 @@ bool Skin::load(const QString& name, bool kns)
                                tabBar.readEntry("green", 0),
                                tabBar.readEntry("blue", 0));
 
-    m_tabBarSeparatorImage.load(tabDir + tabBar.readEntry("separator_image", ""));
-    m_tabBarUnselectedBackgroundImage.load(tabDir + tabBar.readEntry("unselected_background", ""));
-    m_tabBarSelectedBackgroundImage.load(tabDir + tabBar.readEntry("selected_background", ""));
-    m_tabBarUnselectedLeftCornerImage.load(tabDir + tabBar.readEntry("unselected_left_corner", ""));
-    m_tabBarUnselectedRightCornerImage.load(tabDir + tabBar.readEntry("unselected_right_corner", ""));
-    m_tabBarSelectedLeftCornerImage.load(tabDir + tabBar.readEntry("selected_left_corner", ""));
-    m_tabBarSelectedRightCornerImage.load(tabDir + tabBar.readEntry("selected_right_corner", ""));
+    loadImage(m_tabBarSeparatorImage, tabDir + tabBar.readEntry("separator_image", ""));
+    loadImage(m_tabBarUnselectedBackgroundImage, tabDir + tabBar.readEntry("unselected_background", ""));
+    loadImage(m_tabBarSelectedBackgroundImage, tabDir + tabBar.readEntry("selected_background", ""));
+    loadImage(m_tabBarUnselectedLeftCornerImage, tabDir + tabBar.readEntry("unselected_left_corner", ""));
+    loadImage(m_tabBarUnselectedRightCornerImage, tabDir + tabBar.readEntry("unselected_right_corner", ""));
+    loadImage(m_tabBarSelectedLeftCornerImage, tabDir + tabBar.readEntry("selected_left_corner", ""));
+    loadImage(m_tabBarSelectedRightCornerImage, tabDir + tabBar.readEntry("selected_right_corner", ""));
 
-    m_tabBarPreventClosingImage.load(tabDir + tabBar.readEntry("prevent_closing_image", ""));
+    loadImage(m_tabBarPreventClosingImage, tabDir + tabBar.readEntry("prevent_closing_image", ""));
     m_tabBarPreventClosingImagePosition.setX(tabBar.readEntry("prevent_closing_image_x", 0));
     m_tabBarPreventClosingImagePosition.setY(tabBar.readEntry("prevent_closing_image_y", 0));
 
 
     KConfigGroup tabBarBackground = tabConfig.group("Background");
 
-    m_tabBarBackgroundImage.load(tabDir + tabBarBackground.readEntry("back_image", ""));
-    m_tabBarLeftCornerImage.load(tabDir + tabBarBackground.readEntry("left_corner", ""));
-    m_tabBarRightCornerImage.load(tabDir + tabBarBackground.readEntry("right_corner", ""));
+    loadImage(m_tabBarBackgroundImage, tabDir + tabBarBackground.readEntry("back_image", ""));
+    loadImage(m_tabBarLeftCornerImage, tabDir + tabBarBackground.readEntry("left_corner", ""));
+    loadImage(m_tabBarRightCornerImage, tabDir + tabBarBackground.readEntry("right_corner", ""));
 
 
     KConfigGroup tabBarNewTabButton = tabConfig.group("PlusButton");
@@ -152,9 +159,7 @@ bool Skin::load(const QString& name, bool kns)
     m_tabBarNewTabButtonPosition.setX(tabBarNewTabButton.readEntry("x", 0));
     m_tabBarNewTabButtonPosition.setY(tabBarNewTabButton.readEntry("y", 0));
 
-    m_tabBarNewTabButtonStyleSheet = buttonStyleSheet(tabDir + tabBarNewTabButton.readEntry("up_image", ""),
-                                                      tabDir + tabBarNewTabButton.readEntry("over_image", ""),
-                                                      tabDir + tabBarNewTabButton.readEntry("down_image", ""));
+    loadButtonImages(m_tabBarNewTabButtonImages, tabDir, tabBarNewTabButton);
 
 
     KConfigGroup tabBarCloseTabButton = tabConfig.group("MinusButton");
@@ -162,54 +167,199 @@ bool Skin::load(const QString& name, bool kns)
     m_tabBarCloseTabButtonPosition.setX(tabBarCloseTabButton.readEntry("x", 0));
     m_tabBarCloseTabButtonPosition.setY(tabBarCloseTabButton.readEntry("y", 0));
 
-    m_tabBarCloseTabButtonStyleSheet = buttonStyleSheet(tabDir + tabBarCloseTabButton.readEntry("up_image", ""),
-                                                        tabDir + tabBarCloseTabButton.readEntry("over_image", ""),
-                                                        tabDir + tabBarCloseTabButton.readEntry("down_image", ""));
+    loadButtonImages(m_tabBarCloseTabButtonImages, tabDir, tabBarCloseTabButton);
+
+    if (m_tabBarPreventClosingImage.isNull())
+        updateTabBarPreventClosingImageCache();
+
+    prepareAssets();
+
+    return true;
+}
+
+bool Skin::setDevicePixelRatio(qreal ratio)
+{
+    if (qFuzzyCompare(ratio, m_devicePixelRatio)) return false;
+
+    m_devicePixelRatio = ratio;
+
+    // Images already rendered for this ratio come straight from m_renderCache.
+    for (int index = 0; index < m_images.count(); ++index)
+        *m_images.at(index).first = renderImage(m_images.at(index).second);
 
     if (m_tabBarPreventClosingImage.isNull())
         updateTabBarPreventClosingImageCache();
 
+    prepareAssets();
+
     return true;
 }
 
-const QString Skin::buttonStyleSheet(const QString& up, const QString& over, const QString& down)
+void Skin::prepareAssets()
+{
+    m_titleBarLeftCornerRegion = imageRegion(m_titleBarLeftCornerImage);
+    m_titleBarRightCornerRegion = imageRegion(m_titleBarRightCornerImage);
+
+    m_titleBarPixmap = QPixmap();
+    m_titleBarMask = QRegion();
+    m_titleBarMaskWidth = -1;
+}
+
+const QPixmap& Skin::titleBarPixmap(int width)
+{
+    if (!m_titleBarPixmap.isNull() && imageSize(m_titleBarPixmap).width() == width)
+        return m_titleBarPixmap;
+
+    int height = imageSize(m_titleBarBackgroundImage).height();
+
+    if (width <= 0 || height <= 0)
+    {
+        m_titleBarPixmap = QPixmap();
+
+        return m_titleBarPixmap;
+    }
+
+    int leftCornerWidth = imageSize(m_titleBarLeftCornerImage).width();
+    int rightCornerWidth = imageSize(m_titleBarRightCornerImage).width();
+
+    m_titleBarPixmap = QPixmap(QSize(width, height) * m_devicePixelRatio);
+    m_titleBarPixmap.setDevicePixelRatio(m_devicePixelRatio);
+    m_titleBarPixmap.fill(Qt::transparent);
+
+    QPainter painter(&m_titleBarPixmap);
+
+    painter.drawTiledPixmap(leftCornerWidth, 0, width - leftCornerWidth - rightCornerWidth, height,
+                            m_titleBarBackgroundImage);
+
+    painter.drawPixmap(0, 0, m_titleBarLeftCornerImage);
+    painter.drawPixmap(width - rightCornerWidth, 0, m_titleBarRightCornerImage);
+
+    painter.end();
+
+    return m_titleBarPixmap;
+}
+
+const QRegion& Skin::titleBarMask(int width)
+{
+    if (m_titleBarMaskWidth == width)
+        return m_titleBarMask;
+
+    int leftCornerWidth = imageSize(m_titleBarLeftCornerImage).width();
+    int rightCornerWidth = imageSize(m_titleBarRightCornerImage).width();
+
+    m_titleBarMask = m_titleBarLeftCornerRegion;
+
+    m_titleBarMask += QRegion(QRect(0, 0, width - leftCornerWidth - rightCornerWidth,
+        imageSize(m_titleBarBackgroundImage).height())).translated(leftCornerWidth, 0);
+
+    m_titleBarMask += m_titleBarRightCornerRegion.translated(width - rightCornerWidth, 0);
+
+    m_titleBarMaskWidth = width;
+
+    return m_titleBarMask;
+}
+
+QSize Skin::imageSize(const QPixmap& pixmap)
+{
+    return pixmap.size() / pixmap.devicePixelRatio();
+}
+
+QRegion Skin::imageRegion(const QPixmap& pixmap)
+{
+    if (!pixmap.hasAlpha())
+        return QRegion(QRect(QPoint(0, 0), imageSize(pixmap)));
+
+    if (pixmap.devicePixelRatio() == 1.0)
+        return QRegion(pixmap.mask());
+
+    return QRegion(QBitmap(pixmap.mask().scaled(imageSize(pixmap))));
+}
+
+void Skin::loadImage(QPixmap& pixmap, const QString& path)
 {
-    QString styleSheet;
+    m_images << qMakePair(&pixmap, path);
 
-    QString borderBit(QStringLiteral("border: none;"));
+    pixmap = renderImage(path);
+}
+
+QPixmap Skin::renderImage(const QString& path)
+{
+    QFileInfo info(path);
+
+    if (!info.isFile()) return QPixmap();
+
+    QString key = path + QLatin1Char('@') + QString::number(m_devicePixelRatio);
 
-    QPixmap buttonImage(up);
-    QString w(QString::number(buttonImage.width()));
-    QString h(QString::number(buttonImage.height()));
+    if (m_renderCache.contains(key))
+        return m_renderCache.value(key);
 
-    QString sizeBit(QStringLiteral("min-width:") + w + QStringLiteral("; min-height:") + h
-        + QStringLiteral("; max-width:") + w + QStringLiteral("; max-height:") + h + QStringLiteral(";"));
+    QPixmap pixmap;
 
-    styleSheet.append(QStringLiteral("QPushButton {") + borderBit + QStringLiteral("image:url(")
-        + up + QStringLiteral(");") + sizeBit + QStringLiteral("}"));
-    styleSheet.append(QStringLiteral("QPushButton::hover {") + borderBit + QStringLiteral("image:url(")
-        + over + QStringLiteral(");") + sizeBit + QStringLiteral("}"));
-    styleSheet.append(QStringLiteral("QPushButton::pressed {") + borderBit + QStringLiteral("image:url(")
-        + down + QStringLiteral(");") + sizeBit + QStringLiteral("}"));
-    styleSheet.append(QStringLiteral("QPushButton::checked {") + borderBit + QStringLiteral("image:url(")
-        + down + QStringLiteral(");") + sizeBit + QStringLiteral("}"));
-    styleSheet.append(QStringLiteral("QPushButton::open {") + borderBit + QStringLiteral("image:url(")
-        + down + QStringLiteral(");") + sizeBit + QStringLiteral("}"));
-    styleSheet.append(QStringLiteral("QPushButton::menu-indicator { left: ") + w + QStringLiteral(" }"));
+    // Skins may ship an SVG next to each PNG; the PNG still decides the logical size
+    // so that positions in the .skin files keep working.
+    QString svgPath = info.absolutePath() + QLatin1Char('/') + info.completeBaseName() + QStringLiteral(".svg");
+
+    if (m_devicePixelRatio != 1.0 && QFile::exists(svgPath))
+    {
+        QSize size = QImageReader(path).size();
+
+        if (info.suffix() == QStringLiteral("svg") || !size.isValid())
+            size = QSvgRenderer(svgPath).defaultSize();
+
+        pixmap = renderSvg(svgPath, size);
+    }
 
-    styleSheet.append(QStringLiteral("QToolButton {") + borderBit + QStringLiteral("image:url(")
-        + up + QStringLiteral(");") + sizeBit + QStringLiteral("}"));
-    styleSheet.append(QStringLiteral("QToolButton::hover {") + borderBit + QStringLiteral("image:url(")
-        + over + QStringLiteral(");") + sizeBit + QStringLiteral("}"));
-    styleSheet.append(QStringLiteral("QToolButton::pressed {") + borderBit + QStringLiteral("image:url(")
-        + down + QStringLiteral(");") + sizeBit + QStringLiteral("}"));
-    styleSheet.append(QStringLiteral("QToolButton::checked {") + borderBit + QStringLiteral("image:url(")
-        + down + QStringLiteral(");") + sizeBit + QStringLiteral("}"));
-    styleSheet.append(QStringLiteral("QToolButton::open {") + borderBit + QStringLiteral("image:url(")
-        + down + QStringLiteral(");") + sizeBit + QStringLiteral("}"));
-    styleSheet.append(QStringLiteral("QToolButton::menu-indicator { left: ") + w + QStringLiteral(" }"));
+    if (pixmap.isNull())
+        pixmap.load(path);
 
-    return styleSheet;
+    m_renderCache.insert(key, pixmap);
+
+    return pixmap;
+}
+
+QPixmap Skin::renderSvg(const QString& svgPath, const QSize& size)
+{
+    if (!size.isValid()) return QPixmap();
+
+    QFileInfo info(svgPath);
+    QSize pixelSize = size * m_devicePixelRatio;
+
+    QString cacheDir = QStandardPaths::writableLocation(QStandardPaths::CacheLocation) + QStringLiteral("/skins/");
+    QString cacheName = QString::fromLatin1(QCryptographicHash::hash(svgPath.toUtf8(), QCryptographicHash::Sha1).toHex())
+        + QLatin1Char('-') + QString::number(info.lastModified().toTime_t())
+        + QLatin1Char('-') + QString::number(pixelSize.width()) + QLatin1Char('x') + QString::number(pixelSize.height())
+        + QStringLiteral(".png");
+
+    QImage image(cacheDir + cacheName);
+
+    if (image.size() != pixelSize)
+    {
+        QSvgRenderer renderer(svgPath);
+
+        if (!renderer.isValid()) return QPixmap();
+
+        image = QImage(pixelSize, QImage::Format_ARGB32_Premultiplied);
+        image.fill(Qt::transparent);
+
+        QPainter painter(&image);
+        renderer.render(&painter);
+        painter.end();
+
+        if (QDir().mkpath(cacheDir))
+            image.save(cacheDir + cacheName);
+    }
+
+    QPixmap pixmap = QPixmap::fromImage(image);
+    pixmap.setDevicePixelRatio(m_devicePixelRatio);
+
+    return pixmap;
+}
+
+void Skin::loadButtonImages(ButtonImages& images, const QString& dir, const KConfigGroup& group)
+{
+    loadImage(images.up, dir + group.readEntry("up_image", ""));
+    loadImage(images.over, dir + group.readEntry("over_image", ""));
+    loadImage(images.down, dir + group.readEntry("down_image", ""));
 }
 
 const QPixmap Skin::tabBarPreventClosingImage()
@@ -224,7 +374,7 @@ void Skin::updateTabBarPreventClosingImageCache()
 {
     // Get the target image size from the tabBar height, acquired from
     // background image, minus (2 * y position) of the lock icon.
-    int m_IconSize = m_tabBarBackgroundImage.height() -
+    int m_IconSize = imageSize(m_tabBarBackgroundImage).height() -
         (2 * m_tabBarPreventClosingImagePosition.y());
 
     // Get the system lock icon in a generous size.
@@ -23,21 +23,41 @@
 #define SKIN_H
 
 
+#include <QHash>
+#include <QList>
 #include <QObject>
+#include <QPair>
 #include <QPixmap>
+#include <QRegion>
 #include <QString>
 
 
+class KConfigGroup;
+
+
 class Skin : public QObject
 {
     Q_OBJECT
 
     public:
+        struct ButtonImages
+        {
+            QPixmap up;
+            QPixmap over;
+            QPixmap down;
+        };
+
         explicit Skin();
         ~Skin();
 
         bool load(const QString& name, bool kns = false);
 
+        qreal devicePixelRatio() { return m_devicePixelRatio; }
+        bool setDevicePixelRatio(qreal ratio);
+
+        static QSize imageSize(const QPixmap& pixmap);
+        static QRegion imageRegion(const QPixmap& pixmap);
+
 
         const QColor& borderColor() { return m_borderColor; }
         int borderWidth() { return m_borderWidth; }
@@ -47,14 +67,17 @@ class Skin : public QObject
         const QPixmap& titleBarLeftCornerImage() { return m_titleBarLeftCornerImage; }
         const QPixmap& titleBarRightCornerImage() { return m_titleBarRightCornerImage; }
 
+        const QPixmap& titleBarPixmap(int width);
+        const QRegion& titleBarMask(int width);
+
         const QPoint& titleBarFocusButtonPosition() { return m_titleBarFocusButtonPosition; }
-        const QString titleBarFocusButtonStyleSheet() { return m_titleBarFocusButtonStyleSheet; }
+        const ButtonImages& titleBarFocusButtonImages() { return m_titleBarFocusButtonImages; }
 
         const QPoint& titleBarMenuButtonPosition() { return m_titleBarMenuButtonPosition; }
-        const QString titleBarMenuButtonStyleSheet() { return m_titleBarMenuButtonStyleSheet; }
+        const ButtonImages& titleBarMenuButtonImages() { return m_titleBarMenuButtonImages; }
 
         const QPoint& titleBarQuitButtonPosition() { return m_titleBarQuitButtonPosition; }
-        const QString titleBarQuitButtonStyleSheet() { return m_titleBarQuitButtonStyleSheet; }
+        const ButtonImages& titleBarQuitButtonImages() { return m_titleBarQuitButtonImages; }
 
         const QString titleBarText() { return m_titleBarText; }
         const QPoint& titleBarTextPosition() { return m_titleBarTextPosition; }
@@ -81,10 +104,10 @@ class Skin : public QObject
         const QPixmap& tabBarRightCornerImage() { return m_tabBarRightCornerImage; }
 
         const QPoint& tabBarNewTabButtonPosition() { return m_tabBarNewTabButtonPosition; }
-        const QString tabBarNewTabButtonStyleSheet() { return m_tabBarNewTabButtonStyleSheet; }
+        const ButtonImages& tabBarNewTabButtonImages() { return m_tabBarNewTabButtonImages; }
 
         const QPoint& tabBarCloseTabButtonPosition() { return m_tabBarCloseTabButtonPosition; }
-        const QString tabBarCloseTabButtonStyleSheet() { return m_tabBarCloseTabButtonStyleSheet; }
+        const ButtonImages& tabBarCloseTabButtonImages() { return m_tabBarCloseTabButtonImages; }
 
 
     Q_SIGNALS:
@@ -96,10 +119,29 @@ class Skin : public QObject
 
 
     private:
-        const QString buttonStyleSheet(const QString& up, const QString& over, const QString& down);
+        void loadButtonImages(ButtonImages& images, const QString& dir, const KConfigGroup& group);
 
         void updateTabBarPreventClosingImageCache();
 
+        void loadImage(QPixmap& pixmap, const QString& path);
+        QPixmap renderImage(const QString& path);
+        QPixmap renderSvg(const QString& svgPath, const QSize& size);
+        void prepareAssets();
+
+        qreal m_devicePixelRatio;
+
+        // Every skin image with the file it was loaded from, so it can be looked up
+        // again for another pixel ratio.
+        QList<QPair<QPixmap*, QString> > m_images;
+        QHash<QString, QPixmap> m_renderCache;
+
+        // Composited title bar and its mask for the last width asked for.
+        QRegion m_titleBarLeftCornerRegion;
+        QRegion m_titleBarRightCornerRegion;
+        QPixmap m_titleBarPixmap;
+        QRegion m_titleBarMask;
+        int m_titleBarMaskWidth;
+
         QColor m_borderColor;
         int m_borderWidth;
 
@@ -109,13 +151,13 @@ class Skin : public QObject
         QPixmap m_titleBarRightCornerImage;
 
         QPoint m_titleBarFocusButtonPosition;
-        QString m_titleBarFocusButtonStyleSheet;
+        ButtonImages m_titleBarFocusButtonImages;
 
         QPoint m_titleBarMenuButtonPosition;
-        QString m_titleBarMenuButtonStyleSheet;
+        ButtonImages m_titleBarMenuButtonImages;
 
         QPoint m_titleBarQuitButtonPosition;
-        QString m_titleBarQuitButtonStyleSheet;
+        ButtonImages m_titleBarQuitButtonImages;
 
         QString m_titleBarText;
         QPoint m_titleBarTextPosition;
@@ -142,10 +184,10 @@ class Skin : public QObject
         QPixmap m_tabBarRightCornerImage;
 
         QPoint m_tabBarNewTabButtonPosition;
-        QString m_tabBarNewTabButtonStyleSheet;
+        ButtonImages m_tabBarNewTabButtonImages;
 
         QPoint m_tabBarCloseTabButtonPosition;
-        QString m_tabBarCloseTabButtonStyleSheet;
+        ButtonImages m_tabBarCloseTabButtonImages;
 };
 
 #endif
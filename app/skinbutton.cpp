@@ -0,0 +1,83 @@
+/*
+  This program is free software; you can redistribute it and/or
+  modify it under the terms of the GNU General Public License as
+  published by the Free Software Foundation; either version 2 of
+  the License or (at your option) version 3 or any later version
+  accepted by the membership of KDE e.V. (or its successor appro-
+  ved by the membership of KDE e.V.), which shall act as a proxy
+  defined in Section 14 of version 3 of the license.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program. If not, see http://www.gnu.org/licenses/.
+*/
+
+
+
+#include "skinbutton.h"
+#include "skin.h"
+
+#include <QPainter>
+
+
+SkinButton::SkinButton(QWidget* parent) : QToolButton(parent)
+{
+    setFocusPolicy(Qt::NoFocus);
+    setAttribute(Qt::WA_NoSystemBackground);
+}
+
+SkinButton::~SkinButton()
+{
+}
+
+void SkinButton::setImages(const QPixmap& up, const QPixmap& over, const QPixmap& down)
+{
+    m_upImage = up;
+    m_overImage = over.isNull() ? up : over;
+    m_downImage = down.isNull() ? up : down;
+
+    setFixedSize(Skin::imageSize(m_upImage));
+
+    update();
+}
+
+QSize SkinButton::sizeHint() const
+{
+    return Skin::imageSize(m_upImage);
+}
+
+QSize SkinButton::minimumSizeHint() const
+{
+    return sizeHint();
+}
+
+void SkinButton::paintEvent(QPaintEvent*)
+{
+    QPainter painter(this);
+
+    // A button with its menu open is down as well.
+    if (isDown() || isChecked())
+        painter.drawPixmap(0, 0, m_downImage);
+    else if (underMouse())
+        painter.drawPixmap(0, 0, m_overImage);
+    else
+        painter.drawPixmap(0, 0, m_upImage);
+}
+
+void SkinButton::enterEvent(QEvent* event)
+{
+    update();
+
+    QToolButton::enterEvent(event);
+}
+
+void SkinButton::leaveEvent(QEvent* event)
+{
+    update();
+
+    QToolButton::leaveEvent(event);
+}
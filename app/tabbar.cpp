@@ -21,9 +21,14 @@
 
 
 #include "tabbar.h"
+#include "commandscheduler.h"
 #include "mainwindow.h"
+#include "metrics.h"
+#include "quickswitcher.h"
 #include "skin.h"
+#include "skinbutton.h"
 #include "session.h"
+#include "sessionjournal.h"
 #include "sessionstack.h"
 #include "settings.h"
 #include "layoutconfig.h"
@@ -33,13 +38,17 @@
 
 #include <QApplication>
 #include <QBitmap>
+#include <QDir>
+#include <QFileSystemWatcher>
 #include <QFontDatabase>
 #include <QLineEdit>
 #include <QMenu>
 #include <QPainter>
-#include <QPushButton>
+#include <QStyleOption>
 #include <QtDBus/QtDBus>
+#include <QTimer>
 #include <QToolButton>
+#include <QVector>
 #include <QWheelEvent>
 #include <QWhatsThis>
 
@@ -47,13 +56,13 @@
 #include <QDrag>
 #include <QLabel>
 
-#define DECLARE_CURRENT_GROUP QList<int> &m_tabs = m_groups[active_group].tabs;
+#include <algorithm>
 
-#define dbg_QRect(name) dbgQRect(#name,name);
+#define OVERFLOW_INDICATOR_WIDTH 14
+
+#define DECLARE_CURRENT_GROUP const QList<int> &m_tabs = m_model.tabs(active_group);
 
-TabGroup::TabGroup(const QString &t, bool is_locked):
-    title(t), locked(is_locked), selected_tab(0)
-{}
+#define dbg_QRect(name) dbgQRect(#name,name);
 
 TabBar::TabBar(MainWindow* mainWindow) : QWidget(mainWindow)
 {
@@ -72,12 +81,43 @@ TabBar::TabBar(MainWindow* mainWindow) : QWidget(mainWindow)
 
     m_dropIndicator = 0;
 
+    m_layoutDirty = true;
+    m_selectedTabIndex = -1;
+
+    m_tabScroll = 0;
+    m_groupScroll = 0;
+    m_revealSelection = true;
+
+    m_skinGeneration = 0;
+    m_cornerClipX = -1;
+    m_buttonCache.setMaxCost(8 * 1024);
+
     disable_groups_cfg_update = false;
+    m_restoringLayout = false;
 
     m_mainWindow = mainWindow;
 
     m_skin = mainWindow->skin();
-    connect(m_skin, SIGNAL(iconChanged()), this, SLOT(repaint()));
+    connect(m_skin, SIGNAL(iconChanged()), this, SLOT(update()));
+
+    m_journal = new SessionJournal(this);
+
+    m_quickSwitcher = new QuickSwitcher(&m_switchIndex, this);
+    connect(m_quickSwitcher, SIGNAL(sessionChosen(int)), this, SLOT(jumpToSession(int)));
+
+    m_layoutWatcher = 0;
+    m_layoutSize = -1;
+
+    // One deferred session is started per event loop turn so input and painting stay responsive.
+    m_realizationTimer = new QTimer(this);
+    m_realizationTimer->setSingleShot(true);
+    m_realizationTimer->setInterval(0);
+    connect(m_realizationTimer, SIGNAL(timeout()), this, SLOT(realizeNextSession()));
+
+    m_layoutReloadTimer = new QTimer(this);
+    m_layoutReloadTimer->setSingleShot(true);
+    m_layoutReloadTimer->setInterval(200);
+    connect(m_layoutReloadTimer, SIGNAL(timeout()), this, SLOT(checkLayoutFile()));
 
     m_tabContextMenu = new QMenu(this);
     connect(m_tabContextMenu, SIGNAL(hovered(QAction*)), this, SLOT(contextMenuActionHovered(QAction*)));
@@ -92,28 +132,24 @@ TabBar::TabBar(MainWindow* mainWindow) : QWidget(mainWindow)
     m_sessionMenu = new QMenu(this);
     connect(m_sessionMenu, SIGNAL(aboutToShow()), this, SLOT(readySessionMenu()));
 
-    m_newTabButton = new QToolButton(this);
-    m_newTabButton->setFocusPolicy(Qt::NoFocus);
+    m_newTabButton = new SkinButton(this);
     m_newTabButton->setMenu(m_sessionMenu);
     m_newTabButton->setPopupMode(QToolButton::DelayedPopup);
     m_newTabButton->setToolTip(xi18nc("@info:tooltip", "New Session"));
     m_newTabButton->setWhatsThis(xi18nc("@info:whatsthis", "Adds a new session. Press and hold to select session type from menu."));
     connect(m_newTabButton, SIGNAL(clicked()), this, SIGNAL(newTabRequested()));
 
-    m_newGroupButton = new QToolButton(this);
-    m_newGroupButton->setFocusPolicy(Qt::NoFocus);
+    m_newGroupButton = new SkinButton(this);
     m_newGroupButton->setToolTip(i18nc("@info:tooltip", "New Group"));
     m_newGroupButton->setWhatsThis(i18nc("@info:whatsthis", "Adds a new group."));
     connect(m_newGroupButton, SIGNAL(clicked()), this, SLOT(addGroup()));
 
-    m_closeTabButton = new QPushButton(this);
-    m_closeTabButton->setFocusPolicy(Qt::NoFocus);
+    m_closeTabButton = new SkinButton(this);
     m_closeTabButton->setToolTip(xi18nc("@info:tooltip", "Close Session"));
     m_closeTabButton->setWhatsThis(xi18nc("@info:whatsthis", "Closes the active session."));
     connect(m_closeTabButton, SIGNAL(clicked()), this, SLOT(closeTabButtonClicked()));
 
-    m_closeGroupButton = new QPushButton(this);
-    m_closeGroupButton->setFocusPolicy(Qt::NoFocus);
+    m_closeGroupButton = new SkinButton(this);
     m_closeGroupButton->setToolTip(i18nc("@info:tooltip", "Close Group"));
     m_closeGroupButton->setWhatsThis(i18nc("@info:whatsthis", "Closes the active group."));
     connect(m_closeGroupButton, SIGNAL(clicked()), this, SLOT(closeGroup()));
@@ -136,13 +172,15 @@ TabBar::~TabBar()
 
 void TabBar::applySkin()
 {
-    resize(width(), m_skin->tabBarBackgroundImage().height()*2);
+    resize(width(), Skin::imageSize(m_skin->tabBarBackgroundImage()).height()*2);
 
-    m_newTabButton->setStyleSheet(m_skin->tabBarNewTabButtonStyleSheet());
-    m_newGroupButton->setStyleSheet(m_skin->tabBarNewTabButtonStyleSheet());
+    const Skin::ButtonImages& newImages = m_skin->tabBarNewTabButtonImages();
+    m_newTabButton->setImages(newImages.up, newImages.over, newImages.down);
+    m_newGroupButton->setImages(newImages.up, newImages.over, newImages.down);
 
-    m_closeTabButton->setStyleSheet(m_skin->tabBarCloseTabButtonStyleSheet());
-    m_closeGroupButton->setStyleSheet(m_skin->tabBarCloseTabButtonStyleSheet());
+    const Skin::ButtonImages& closeImages = m_skin->tabBarCloseTabButtonImages();
+    m_closeTabButton->setImages(closeImages.up, closeImages.over, closeImages.down);
+    m_closeGroupButton->setImages(closeImages.up, closeImages.over, closeImages.down);
 
     m_newTabButton->move( m_skin->tabBarNewTabButtonPosition().x(),
                           m_skin->tabBarNewTabButtonPosition().y());
@@ -154,54 +192,424 @@ void TabBar::applySkin()
     m_closeGroupButton->move(width() - m_skin->tabBarCloseTabButtonPosition().x(),
                            m_skin->tabBarCloseTabButtonPosition().y()+height()/2);
 
-    repaint();
+    ++m_skinGeneration;
+    m_buttonCache.clear();
+    m_cornerClipRegion = QRegion();
+
+    invalidateLayout();
+    update();
 }
 
 void TabBar::setGroupLocked(int group_id, bool locked)
 {
     if(group_id == -1) group_id = active_group;
-    if(group_id < 0 || group_id > m_groups.count() -1) return;
+    if(group_id < 0 || group_id > m_model.groupCount() -1) return;
 
-    m_groups[group_id].locked = locked;
+    m_model.setGroupLocked(group_id, locked);
+    invalidateLayout();
+    m_journal->setGroupLocked(group_id, locked);
 }
 
 void TabBar::restoreGroupsFromSettings()
 {
+    bool lazy = Settings::lazyLayoutRestore();
+
+    if(Settings::sessionJournal()) {
+        LayoutConfig::TabsGroupsList groups;
+        int active = 0;
+
+        qint64 replay_start = Metrics::self()->elapsed();
+        bool replay_ok = m_journal->replay(groups, active);
+        Metrics::self()->addStartupPhase(QStringLiteral("SessionJournal::replay"), replay_start);
+
+        if(replay_ok) {
+            restoreGroups(groups, active, lazy, false);
+            resetJournal();
+            return;
+        }
+    }
+
     LayoutConfig l;
-    if(!l.read()) {
+    qint64 read_start = Metrics::self()->elapsed();
+    bool read_ok = l.read();
+    Metrics::self()->addStartupPhase(QStringLiteral("LayoutConfig::read"), read_start);
+    if(!read_ok) {
         emit newTabRequested();
+        resetJournal();
         return;
     }
 
-    for(const auto &group : l.groups()) {
+    m_mainWindow->sessionStack()->commandScheduler()->setLimit(l.exec_limit());
+
+    restoreGroups(l.groups(), l.active_group(), lazy, true);
+    resetJournal();
+}
+
+void TabBar::restoreGroups(const LayoutConfig::TabsGroupsList &groups, int active_group_index, bool lazy, bool from_layout)
+{
+    SessionStack* sessionStack = m_mainWindow->sessionStack();
+
+    // Tabs are not raised while restoring; the active group's selected tab is raised by selectGroup() below.
+    m_restoringLayout = true;
+
+    for(int group_index = 0; group_index < groups.count(); group_index++) {
+        const LayoutConfig::TabsGroup &group = groups.at(group_index);
+        bool active = (group_index == active_group_index);
+
         //create group
-        m_groups.append(TabGroup(group.name,group.locked));
-        active_group = m_groups.size()-1;
+        active_group = m_model.appendGroup(group.name,group.locked);
+        m_model.setGroupFromLayout(active_group, from_layout || group.from_layout);
 
         //create tabs
-        TabGroup &g = m_groups.back();
         if(group.tabs.empty()) {
-            emit newTabRequested();
+            int sessionId = sessionStack->addSession(Session::Single, !active);
+            if(!active)
+                queueRealization(sessionId);
             continue;
         }
-        SessionStack* sessionStack = m_mainWindow->sessionStack();
-        for(const auto &tab: group.tabs) {
-            emit newTabRequested();
-            if(tab.name!=QStringLiteral("auto")) {
-                setTabTitleInteractive(m_selectedSessionId, tab.name);
+        for(int tab_index = 0; tab_index < group.tabs.count(); tab_index++) {
+            const LayoutConfig::Tab &tab = group.tabs.at(tab_index);
+            // The selected group is built right away, everything else once the window is up.
+            bool deferred = !active || (lazy && tab_index != group.selected_tab);
+
+            int sessionId = addLayoutTab(active_group, tab, deferred);
+            //the journal remembers which tabs came from the layout file
+            const QString &origin = from_layout ? tab.name : tab.origin;
+            if(!origin.isEmpty()) {
+                m_layoutTabNames.insert(sessionId, origin);
             }
-            if(!tab.exec.isEmpty())
-                sessionStack->runCommand(tab.exec);
         }
-        g.selected_tab = group.selected_tab;
+        m_model.setSelectedTab(active_group, group.selected_tab);
     }
 
-    if(m_groups.count())
-        selectGroup(l.active_group());
+    m_restoringLayout = false;
+
+    if(m_model.groupCount())
+        selectGroup(active_group_index);
     else
         emit newTabRequested();
 }
 
+int TabBar::addLayoutTab(int group_id, const LayoutConfig::Tab &tab, bool deferred)
+{
+    SessionStack* sessionStack = m_mainWindow->sessionStack();
+
+    // addTab() appends to the active group and raises the new tab unless a layout is being restored.
+    int current_group = active_group;
+    bool restoring = m_restoringLayout;
+    active_group = group_id;
+    m_restoringLayout = true;
+
+    int sessionId = sessionStack->addSession(Session::Single, deferred, tab.exec, tab.layout);
+
+    active_group = current_group;
+    m_restoringLayout = restoring;
+
+    if(deferred)
+        queueRealization(sessionId);
+
+    if(tab.name!=QStringLiteral("auto")) {
+        setTabTitleInteractive(sessionId, tab.name);
+    }
+    if(!tab.closable) {
+        sessionStack->setSessionClosable(sessionId, false);
+    }
+
+    return sessionId;
+}
+
+void TabBar::queueRealization(int sessionId)
+{
+    // With lazy restore, deferred sessions are only started when they are first shown.
+    if(Settings::lazyLayoutRestore()) return;
+
+    m_realizationQueue.append(sessionId);
+    m_pendingSessions.insert(sessionId);
+
+    if(!m_realizationTimer->isActive())
+        m_realizationTimer->start();
+}
+
+void TabBar::realizeNextSession()
+{
+    SessionStack* sessionStack = m_mainWindow->sessionStack();
+
+    while(!m_realizationQueue.isEmpty()) {
+        int sessionId = m_realizationQueue.takeFirst();
+        m_pendingSessions.remove(sessionId);
+
+        // Sessions raised by the user in the meantime are already running.
+        if(sessionStack->isSessionRealized(sessionId)) continue;
+
+        sessionStack->realizeSession(sessionId);
+        break;
+    }
+
+    if(!m_realizationQueue.isEmpty())
+        m_realizationTimer->start();
+
+    invalidateLayout();
+}
+
+void TabBar::applySettings()
+{
+    // Nothing to record before the groups have been restored.
+    if(!m_model.isEmpty() && Settings::sessionJournal() != m_journal->isRecording())
+        resetJournal();
+
+    if(Settings::reloadLayoutOnChange() && !m_layoutWatcher) {
+        LayoutConfig l;
+        QFileInfo info(l.path());
+
+        // Editors often save by replacing the file, so its directory is watched as well.
+        m_layoutWatcher = new QFileSystemWatcher(this);
+        m_layoutWatcher->addPath(info.absolutePath());
+        if(info.exists())
+            m_layoutWatcher->addPath(info.absoluteFilePath());
+        connect(m_layoutWatcher, SIGNAL(fileChanged(QString)), m_layoutReloadTimer, SLOT(start()));
+        connect(m_layoutWatcher, SIGNAL(directoryChanged(QString)), m_layoutReloadTimer, SLOT(start()));
+
+        m_layoutModified = info.lastModified();
+        m_layoutSize = info.exists() ? info.size() : -1;
+    } else if(!Settings::reloadLayoutOnChange() && m_layoutWatcher) {
+        delete m_layoutWatcher;
+        m_layoutWatcher = 0;
+        m_layoutReloadTimer->stop();
+    }
+}
+
+void TabBar::checkLayoutFile()
+{
+    if(!m_layoutWatcher) return;
+
+    LayoutConfig l;
+    QFileInfo info(l.path());
+
+    if(!info.exists()) return;
+
+    if(!m_layoutWatcher->files().contains(info.absoluteFilePath()))
+        m_layoutWatcher->addPath(info.absoluteFilePath());
+
+    if(info.lastModified() == m_layoutModified && info.size() == m_layoutSize) return;
+
+    m_layoutModified = info.lastModified();
+    m_layoutSize = info.size();
+
+    reloadLayout();
+}
+
+void TabBar::reloadLayout()
+{
+    LayoutConfig l;
+    if(!l.read()) return;
+
+    m_mainWindow->sessionStack()->commandScheduler()->setLimit(l.exec_limit());
+
+    const LayoutConfig::TabsGroupsList &groups = l.groups();
+
+    //match layout groups to live groups by title
+    QVector<int> matches(groups.count(), -1);
+    QVector<bool> taken(m_model.groupCount(), false);
+    for(int group_index = 0; group_index < groups.count(); group_index++) {
+        for(int group_id = 0; group_id < m_model.groupCount(); group_id++) {
+            if(!taken[group_id] && m_model.group(group_id).title == groups[group_index].name) {
+                matches[group_index] = group_id;
+                taken[group_id] = true;
+                break;
+            }
+        }
+    }
+
+    //renamed layout groups take the place of the remaining groups created from the layout
+    int candidate = 0;
+    for(int group_index = 0; group_index < groups.count(); group_index++) {
+        if(matches[group_index] != -1) continue;
+        while(candidate < m_model.groupCount() && (taken[candidate] || !m_model.group(candidate).from_layout))
+            candidate++;
+        if(candidate == m_model.groupCount()) break;
+        matches[group_index] = candidate;
+        taken[candidate] = true;
+    }
+
+    QList<int> obsolete_tabs;
+    QList<int> dropped_groups;
+
+    //groups gone from the layout lose the tabs the layout created; their lock is left as it is
+    for(int group_id = 0; group_id < m_model.groupCount(); group_id++) {
+        if(taken[group_id] || !m_model.group(group_id).from_layout) continue;
+        for(int sessionId: m_model.group(group_id).tabs) {
+            if(m_layoutTabNames.contains(sessionId))
+                obsolete_tabs.append(sessionId);
+        }
+        setGroupFromLayout(group_id, false);
+        dropped_groups.append(group_id);
+    }
+
+    for(int group_index = 0; group_index < groups.count(); group_index++) {
+        const LayoutConfig::TabsGroup &group = groups.at(group_index);
+        int group_id = matches[group_index];
+
+        if(group_id == -1) {
+            group_id = m_model.appendGroup(group.name,group.locked);
+            m_journal->addGroup(group.name, group.locked);
+            setGroupFromLayout(group_id, true);
+
+            if(group.tabs.empty())
+                addLayoutTab(group_id, LayoutConfig::Tab("auto"), true);
+            for(const LayoutConfig::Tab &tab: group.tabs)
+                setLayoutTabName(addLayoutTab(group_id, tab, true), tab.name);
+            m_model.setSelectedTab(group_id, group.selected_tab);
+            continue;
+        }
+
+        if(m_model.group(group_id).title != group.name)
+            setGroupTitle(group_id, group.name);
+        if(m_model.group(group_id).locked != group.locked)
+            setGroupLocked(group_id, group.locked);
+        setGroupFromLayout(group_id, true);
+
+        reloadGroupTabs(group_id, group, obsolete_tabs);
+    }
+
+    //closed without asking; locked or busy sessions keep running
+    SessionStack* sessionStack = m_mainWindow->sessionStack();
+    QSet<int> discarded;
+    for(int sessionId: obsolete_tabs) {
+        setLayoutTabName(sessionId, QString());
+        if(sessionStack->discardSession(sessionId))
+            discarded.insert(sessionId);
+    }
+
+    //a dropped group only goes away once every one of its tabs is being closed
+    for(int group_id: dropped_groups) {
+        bool all_discarded = true;
+        for(int sessionId: m_model.group(group_id).tabs) {
+            if(!discarded.contains(sessionId)) {
+                all_discarded = false;
+                break;
+            }
+        }
+        if(all_discarded)
+            m_model.setGroupRemoveWhenEmpty(group_id, true);
+    }
+
+    invalidateLayout();
+}
+
+void TabBar::reloadGroupTabs(int group_id, const LayoutConfig::TabsGroup &group, QList<int> &obsolete_tabs)
+{
+    const QString automatic = QStringLiteral("auto");
+    QList<int> candidates = m_model.group(group_id).tabs;
+    QVector<int> matches(group.tabs.count(), -1);
+
+    //named tabs match tabs carrying the same title, automatic ones match automatic layout tabs
+    for(int tab_index = 0; tab_index < group.tabs.count(); tab_index++) {
+        const QString &name = group.tabs.at(tab_index).name;
+        for(int sessionId: candidates) {
+            bool same = (name == automatic)
+                ? m_layoutTabNames.value(sessionId) == automatic
+                : m_tabTitlesSetInteractive.value(sessionId, false) && m_model.tabTitle(sessionId) == name;
+            if(same) {
+                matches[tab_index] = sessionId;
+                candidates.removeOne(sessionId);
+                break;
+            }
+        }
+    }
+
+    //renamed layout tabs take the place of the remaining named tabs created from the layout
+    for(int tab_index = 0; tab_index < group.tabs.count(); tab_index++) {
+        const QString &name = group.tabs.at(tab_index).name;
+        if(matches[tab_index] != -1 || name == automatic) continue;
+        for(int sessionId: candidates) {
+            if(m_layoutTabNames.contains(sessionId) && m_layoutTabNames.value(sessionId) != automatic) {
+                setTabTitleInteractive(sessionId, name);
+                matches[tab_index] = sessionId;
+                candidates.removeOne(sessionId);
+                break;
+            }
+        }
+    }
+
+    //added tabs go right after the layout tab preceding them in the file
+    int selected = m_model.group(group_id).selected_tab;
+    selected = (selected >= 0 && selected < m_model.tabs(group_id).count())
+        ? m_model.tabs(group_id).at(selected) : -1;
+    int previous = -1;
+    for(int tab_index = 0; tab_index < group.tabs.count(); tab_index++) {
+        const LayoutConfig::Tab &tab = group.tabs.at(tab_index);
+        int sessionId = matches[tab_index];
+        if(sessionId == -1) {
+            sessionId = addLayoutTab(group_id, tab, true);
+            int target = (previous == -1) ? 0 : m_model.indexOf(previous) + 1;
+            if(m_model.indexOf(sessionId) != target) {
+                m_model.moveTab(sessionId, group_id, target);
+                m_journal->moveTab(sessionId, group_id, target);
+            }
+        }
+        setLayoutTabName(sessionId, tab.name);
+        previous = sessionId;
+    }
+    if(selected != -1)
+        m_model.setSelectedTab(group_id, m_model.indexOf(selected));
+
+    for(int sessionId: candidates) {
+        if(m_layoutTabNames.contains(sessionId))
+            obsolete_tabs.append(sessionId);
+    }
+}
+
+void TabBar::setGroupFromLayout(int group_id, bool from_layout)
+{
+    m_model.setGroupFromLayout(group_id, from_layout);
+    m_journal->setGroupFromLayout(group_id, from_layout);
+}
+
+void TabBar::setLayoutTabName(int sessionId, const QString &name)
+{
+    if(name.isEmpty())
+        m_layoutTabNames.remove(sessionId);
+    else
+        m_layoutTabNames.insert(sessionId, name);
+    m_journal->setTabOrigin(sessionId, name);
+}
+
+void TabBar::resetJournal()
+{
+    if(!Settings::sessionJournal()) {
+        m_journal->clear();
+        return;
+    }
+
+    SessionStack* sessionStack = m_mainWindow->sessionStack();
+
+    QList<SessionJournal::Group> groups;
+    QHash<int, SessionJournal::Tab> tabs;
+
+    for(const TabGroup &group: m_model.groups()) {
+        SessionJournal::Group g;
+        g.title = group.title;
+        g.locked = group.locked;
+        g.fromLayout = group.from_layout;
+        g.tabs = group.tabs;
+        if(group.selected_tab >= 0 && group.selected_tab < group.tabs.count())
+            g.selectedSessionId = group.tabs.at(group.selected_tab);
+        groups.append(g);
+
+        for(int sessionId: group.tabs) {
+            SessionJournal::Tab t;
+            if(m_tabTitlesSetInteractive.value(sessionId, false))
+                t.title = m_model.tabTitle(sessionId);
+            t.closable = sessionStack->isSessionClosable(sessionId);
+            t.layout = sessionStack->sessionLayout(sessionId);
+            t.origin = m_layoutTabNames.value(sessionId);
+            tabs.insert(sessionId, t);
+        }
+    }
+
+    m_journal->reset(groups, tabs, active_group);
+}
+
 void TabBar::readyTabContextMenu()
 {
     if (m_tabContextMenu->isEmpty())
@@ -291,14 +699,14 @@ void TabBar::updateGroupToggleActions(int group_id)
     KActionCollection* actionCollection = m_mainWindow->actionCollection();
 
     QAction* toggleAction = actionCollection->action(QStringLiteral("toggle-group-prevent-closing"));
-    toggleAction->setChecked(m_groups[group_id].locked);
+    toggleAction->setChecked(m_model.group(group_id).locked);
 }
 
 void TabBar::updateToggleKeyboardInputMenu(int sessionId)
 {
     DECLARE_CURRENT_GROUP
 
-    if (!m_tabs.contains(sessionId)) return;
+    if (tabIndex(sessionId) == -1) return;
 
     QAction* toggleKeyboardInputAction = m_mainWindow->actionCollection()->action(QStringLiteral("toggle-session-keyboard-input"));
     QAction* anchor = m_toggleKeyboardInputMenu->menuAction();
@@ -348,7 +756,7 @@ void TabBar::updateToggleMonitorActivityMenu(int sessionId)
 {
     DECLARE_CURRENT_GROUP
 
-    if (!m_tabs.contains(sessionId)) return;
+    if (tabIndex(sessionId) == -1) return;
 
     QAction* toggleMonitorActivityAction = m_mainWindow->actionCollection()->action(QStringLiteral("toggle-session-monitor-activity"));
     QAction* anchor = m_toggleMonitorActivityMenu->menuAction();
@@ -398,7 +806,7 @@ void TabBar::updateToggleMonitorSilenceMenu(int sessionId)
 {
     DECLARE_CURRENT_GROUP
 
-    if (!m_tabs.contains(sessionId)) return;
+    if (tabIndex(sessionId) == -1) return;
 
     QAction* toggleMonitorSilenceAction = m_mainWindow->actionCollection()->action(QStringLiteral("toggle-session-monitor-silence"));
     QAction* anchor = m_toggleMonitorSilenceMenu->menuAction();
@@ -498,7 +906,7 @@ void TabBar::contextMenuEvent(QContextMenuEvent* event)
 
             m_mainWindow->setContextDependentActionsQuiet(false);
             DECLARE_CURRENT_GROUP
-            updateMoveActions(m_tabs.indexOf(m_selectedSessionId));
+            updateMoveActions(tabIndex(m_selectedSessionId));
             updateToggleActions(m_selectedSessionId);
             updateToggleKeyboardInputMenu(m_selectedSessionId);
             updateToggleMonitorActivityMenu(m_selectedSessionId);
@@ -537,42 +945,45 @@ void TabBar::resizeEvent(QResizeEvent* event)
     m_newGroupButton->move(m_skin->tabBarNewTabButtonPosition().x(), m_skin->tabBarNewTabButtonPosition().y()+half_height);
     m_closeGroupButton->move(width() - m_skin->tabBarCloseTabButtonPosition().x(), m_skin->tabBarCloseTabButtonPosition().y()+half_height);
 
+    m_cornerClipRegion = QRegion();
+    invalidateLayout();
+
     QWidget::resizeEvent(event);
 }
 
-void TabBar::paintEvent(QPaintEvent*)
+void TabBar::changeEvent(QEvent* event)
+{
+    if (event->type() == QEvent::FontChange || event->type() == QEvent::ApplicationFontChange)
+    {
+        m_buttonCache.clear();
+        invalidateLayout();
+    }
+
+    QWidget::changeEvent(event);
+}
+
+void TabBar::paintEvent(QPaintEvent* event)
 {
+    updateLayout();
+
     QPainter painter(this);
     painter.setPen(m_skin->tabBarTextColor());
-    DECLARE_CURRENT_GROUP
     int x_start = m_skin->tabBarPosition().x();
     int x = x_start;
     int y = m_skin->tabBarPosition().y();
 
-    int half_height = height()/2;
-
-    QRect groupsClipRect(x, y + half_height, m_closeTabButton->x() - x, height() - y - half_height);
+    QRect groupsClipRect = groupRowRect();
     painter.setClipRect(groupsClipRect);
     //dbg_QRect(groupsClipRect);
-    m_groupWidths.clear();
-    for (int index = 0; index < m_groups.count(); ++index)
-    {
-        x = drawGroupButton(x, y + half_height, index, painter);
-        m_groupWidths << x;
-    }
+    paintRow(painter, true, groupsClipRect, event->region());
     //x = x > tabsClipRect.right() ? tabsClipRect.right() + 1 : x;
 
-    x = x_start;
-
-    QRect tabsClipRect(x, y, m_closeTabButton->x() - x, height() - y - half_height);
+    QRect tabsClipRect = tabRowRect();
     painter.setClipRect(tabsClipRect);
     //dbg_QRect(tabsClipRect);
-    m_tabWidths.clear();
-    for (int index = 0; index < m_tabs.count(); ++index)
-    {
-        x = drawButton(x, y, index, painter);
-        m_tabWidths << x;
-    }
+    paintRow(painter, false, tabsClipRect, event->region());
+
+    if (!m_tabItems.isEmpty()) x = m_tabItems.last().right - m_tabScroll;
 
     //const QPixmap& backgroundImage = m_skin->tabBarBackgroundImage();
     const QPixmap& leftCornerImage = m_skin->tabBarLeftCornerImage();
@@ -580,218 +991,571 @@ void TabBar::paintEvent(QPaintEvent*)
 
     x = x > tabsClipRect.right() ? tabsClipRect.right() + 1 : x;
 
-    QRegion backgroundClipRegion(rect());
-    backgroundClipRegion = backgroundClipRegion.subtracted(m_newTabButton->geometry());
-    backgroundClipRegion = backgroundClipRegion.subtracted(m_closeTabButton->geometry());
-    QRect tabsRect(m_skin->tabBarPosition().x(), y, x - m_skin->tabBarPosition().x(),
-        height() - m_skin->tabBarPosition().y());
-    backgroundClipRegion = backgroundClipRegion.subtracted(tabsRect);
-    painter.setClipRegion(backgroundClipRegion);
-
-    painter.drawImage(0, 0, leftCornerImage.toImage());
-    QRect leftCornerImageRect(0, 0, leftCornerImage.width(), height());
-    backgroundClipRegion = backgroundClipRegion.subtracted(leftCornerImageRect);
+    // The clip only changes with the size, the skin or where the tabs end.
+    if (m_cornerClipRegion.isEmpty() || m_cornerClipX != x)
+    {
+        m_cornerClipRegion = QRegion(rect());
+        m_cornerClipRegion -= m_newTabButton->geometry();
+        m_cornerClipRegion -= m_closeTabButton->geometry();
+        m_cornerClipRegion -= QRect(m_skin->tabBarPosition().x(), y, x - m_skin->tabBarPosition().x(),
+            height() - m_skin->tabBarPosition().y());
+        m_cornerClipX = x;
+    }
 
-    painter.drawImage(width() - rightCornerImage.width(), 0, rightCornerImage.toImage());
-    QRect rightCornerImageRect(width() - rightCornerImage.width(), 0, rightCornerImage.width(), height());
-    backgroundClipRegion = backgroundClipRegion.subtracted(rightCornerImageRect);
+    painter.setClipRegion(m_cornerClipRegion);
 
-    painter.setClipRegion(backgroundClipRegion);
+    painter.drawPixmap(0, 0, leftCornerImage);
+    painter.drawPixmap(width() - Skin::imageSize(rightCornerImage).width(), 0, rightCornerImage);
 
     //painter.drawTiledPixmap(0, 0, width(), height(), backgroundImage);
 
     painter.end();
 }
 
-int TabBar::drawButton(int x, int y, int index, QPainter& painter)
+void TabBar::paintRow(QPainter& painter, bool group, const QRect& row, const QRegion& region)
+{
+    const QVector<StripItem>& items = group ? m_groupItems : m_tabItems;
+    int scroll = group ? m_groupScroll : m_tabScroll;
+
+    // Only the buttons inside the visible window of the strip are touched.
+    int index = itemAt(items, row.left() + 1 + scroll);
+    if (index < 0) index = 0;
+
+    for (; index < items.count(); ++index)
+    {
+        QRect buttonRect = itemRect(items.at(index), row, scroll);
+
+        if (buttonRect.left() > row.right()) break;
+
+        if (region.intersects(buttonRect))
+            painter.drawPixmap(buttonRect.topLeft(), buttonPixmap(index, group, buttonRect));
+    }
+
+    if (scroll > 0)
+        drawOverflowIndicator(painter, QStyle::PE_IndicatorArrowLeft, leftIndicatorRect(row));
+
+    if (scroll < maxScroll(items, row))
+        drawOverflowIndicator(painter, QStyle::PE_IndicatorArrowRight, rightIndicatorRect(row));
+}
+
+void TabBar::drawOverflowIndicator(QPainter& painter, QStyle::PrimitiveElement arrow, const QRect& rect)
+{
+    painter.drawTiledPixmap(rect, m_skin->tabBarUnselectedBackgroundImage());
+
+    QStyleOption option;
+    option.initFrom(this);
+    option.rect = rect;
+    option.palette.setColor(QPalette::ButtonText, m_skin->tabBarTextColor());
+    option.palette.setColor(QPalette::WindowText, m_skin->tabBarTextColor());
+
+    style()->drawPrimitive(arrow, &option, &painter, this);
+}
+
+QRect TabBar::leftIndicatorRect(const QRect& row)
+{
+    return QRect(row.left(), row.top(), OVERFLOW_INDICATOR_WIDTH, row.height());
+}
+
+QRect TabBar::rightIndicatorRect(const QRect& row)
+{
+    return QRect(row.right() + 1 - OVERFLOW_INDICATOR_WIDTH, row.top(), OVERFLOW_INDICATOR_WIDTH, row.height());
+}
+
+int TabBar::maxScroll(const QVector<StripItem>& items, const QRect& row)
+{
+    if (items.isEmpty()) return 0;
+
+    return qMax(0, items.last().right - items.first().left - row.width());
+}
+
+void TabBar::revealItem(const QVector<StripItem>& items, int index, int& scroll, const QRect& row)
+{
+    if (index < 0 || index >= items.count()) return;
+
+    const StripItem& item = items.at(index);
+
+    // Leave room for the overflow indicators unless the item sits at either end of the strip.
+    int leftMargin = (index > 0) ? OVERFLOW_INDICATOR_WIDTH : 0;
+    int rightMargin = (index < items.count() - 1) ? OVERFLOW_INDICATOR_WIDTH : 0;
+
+    if (item.left - scroll < row.left() + leftMargin)
+        scroll = item.left - row.left() - leftMargin;
+    else if (item.right - scroll > row.left() + row.width() - rightMargin)
+        scroll = item.right - row.left() - row.width() + rightMargin;
+}
+
+void TabBar::scrollStrip(bool group, int delta)
+{
+    updateLayout();
+
+    const QVector<StripItem>& items = group ? m_groupItems : m_tabItems;
+    int& scroll = group ? m_groupScroll : m_tabScroll;
+    QRect row = group ? groupRowRect() : tabRowRect();
+
+    int value = qBound(0, scroll + delta, maxScroll(items, row));
+
+    if (value == scroll) return;
+
+    scroll = value;
+
+    update(row);
+}
+
+void TabBar::scrollTabsLeft()
+{
+    scrollStrip(false, -tabRowRect().width() / 2);
+}
+
+void TabBar::scrollTabsRight()
+{
+    scrollStrip(false, tabRowRect().width() / 2);
+}
+
+QRect TabBar::tabRowRect()
+{
+    int x = m_skin->tabBarPosition().x();
+    int y = m_skin->tabBarPosition().y();
+
+    return QRect(x, y, m_closeTabButton->x() - x, height() - y - height()/2);
+}
+
+QRect TabBar::groupRowRect()
+{
+    QRect rect = tabRowRect();
+    rect.translate(0, height()/2);
+
+    return rect;
+}
+
+QRect TabBar::itemRect(const StripItem& item, const QRect& row, int scroll)
+{
+    return QRect(item.left - scroll, row.top(), item.right - item.left, row.height());
+}
+
+void TabBar::invalidateLayout()
+{
+    // The layout is rebuilt once per event loop pass, however many changes led up to it.
+    if (m_layoutDirty) return;
+
+    m_layoutDirty = true;
+
+    QTimer::singleShot(0, this, SLOT(updateLayout()));
+}
+
+QRegion TabBar::changedItems(const QVector<StripItem>& oldItems, const QVector<StripItem>& newItems,
+    const QRect& row, int oldScroll, int scroll)
+{
+    // Scrolling or starting/stopping to overflow moves everything in the row.
+    if (scroll != oldScroll || (maxScroll(oldItems, row) > 0) != (maxScroll(newItems, row) > 0))
+        return row;
+
+    QRegion region;
+
+    for (int index = 0; index < qMax(oldItems.count(), newItems.count()); ++index)
+    {
+        if (index >= newItems.count())
+            region += itemRect(oldItems.at(index), row, scroll);
+        else if (index >= oldItems.count())
+            region += itemRect(newItems.at(index), row, scroll);
+        else
+        {
+            const StripItem& oldItem = oldItems.at(index);
+            const StripItem& newItem = newItems.at(index);
+
+            if (oldItem.key == newItem.key && oldItem.left == newItem.left && oldItem.right == newItem.right)
+                continue;
+
+            region += itemRect(oldItem, row, scroll);
+            region += itemRect(newItem, row, scroll);
+        }
+    }
+
+    if (!region.isEmpty() && maxScroll(newItems, row) > 0)
+    {
+        region += leftIndicatorRect(row);
+        region += rightIndicatorRect(row);
+    }
+
+    return region & row;
+}
+
+void TabBar::updateLayout()
+{
+    if (!m_layoutDirty) return;
+
+    m_layoutDirty = false;
+
+    QVector<StripItem> oldTabItems;
+    QVector<StripItem> oldGroupItems;
+    m_tabItems.swap(oldTabItems);
+    m_groupItems.swap(oldGroupItems);
+
+    int oldTabScroll = m_tabScroll;
+    int oldGroupScroll = m_groupScroll;
+
+    buildLayout();
+
+    QRect tabRow = tabRowRect();
+    QRect groupRow = groupRowRect();
+
+    if (m_revealSelection)
+    {
+        m_revealSelection = false;
+
+        revealItem(m_tabItems, m_selectedTabIndex, m_tabScroll, tabRow);
+        revealItem(m_groupItems, active_group, m_groupScroll, groupRow);
+    }
+
+    m_tabScroll = qBound(0, m_tabScroll, maxScroll(m_tabItems, tabRow));
+    m_groupScroll = qBound(0, m_groupScroll, maxScroll(m_groupItems, groupRow));
+
+    // Only buttons that look different or moved are repainted, one row at a time.
+    QRegion dirtyRegion = changedItems(oldGroupItems, m_groupItems, groupRow, oldGroupScroll, m_groupScroll);
+    dirtyRegion += changedItems(oldTabItems, m_tabItems, tabRow, oldTabScroll, m_tabScroll);
+
+    if (!dirtyRegion.isEmpty())
+        update(dirtyRegion);
+}
+
+void TabBar::buildLayout()
+{
+    if (m_model.isEmpty()) return;
+
+    m_font = QFontDatabase::systemFont(QFontDatabase::GeneralFont);
+    m_font.setBold(false);
+    m_boldFont = m_font;
+    m_boldFont.setBold(true);
+
+    QFontMetrics fontMetrics(m_font);
+    QFontMetrics boldFontMetrics(m_boldFont);
+
+    // Titles are elided rather than letting a single button outgrow the strip.
+    int maxTextWidth = qMax(fontMetrics.averageCharWidth(), m_closeTabButton->x() - m_skin->tabBarPosition().x() - 10);
+
+    DECLARE_CURRENT_GROUP
+
+    int x = m_skin->tabBarPosition().x();
+    m_tabItems.resize(m_tabs.count());
+    m_selectedTabIndex = tabIndex(m_selectedSessionId);
+
+    for (int index = 0; index < m_tabs.count(); ++index)
+    {
+        int sessionId = m_tabs.at(index);
+        const QFontMetrics& metrics = (sessionId == m_selectedSessionId) ? boldFontMetrics : fontMetrics;
+
+        StripItem& item = m_tabItems[index];
+        item.text = metrics.elidedText(m_model.tabTitle(sessionId), Qt::ElideRight, maxTextWidth);
+        item.textWidth = metrics.width(item.text) + 10;
+        item.key = QStringLiteral("t|") + item.text + QLatin1Char('|')
+            + QString::number(sessionId == m_selectedSessionId)
+            + QString::number(index == m_selectedTabIndex + 1)
+            + QString::number(index == m_selectedTabIndex - 1)
+            + QString::number(m_mainWindow->sessionStack()->isSessionClosable(sessionId));
+        item.left = x;
+
+        x = drawButton(x, 0, index, 0);
+
+        item.right = x;
+    }
+
+    x = m_skin->tabBarPosition().x();
+    m_groupItems.resize(m_model.groupCount());
+
+    for (int index = 0; index < m_model.groupCount(); ++index)
+    {
+        const QFontMetrics& metrics = (index == active_group) ? boldFontMetrics : fontMetrics;
+
+        StripItem& item = m_groupItems[index];
+        item.text = metrics.elidedText(groupButtonTitle(index), Qt::ElideRight, maxTextWidth);
+        item.textWidth = metrics.width(item.text) + 10;
+        item.key = QStringLiteral("g|") + item.text + QLatin1Char('|')
+            + QString::number(index == active_group)
+            + QString::number(index == active_group + 1)
+            + QString::number(m_model.group(index).locked);
+        item.left = x;
+
+        x = drawGroupButton(x, 0, index, 0);
+
+        item.right = x;
+    }
+}
+
+QPixmap TabBar::buttonPixmap(int index, bool group, const QRect& rect)
+{
+    if (rect.isEmpty()) return QPixmap();
+
+    // QWidget::devicePixelRatio() truncates fractional scales; the skin knows the real one.
+    qreal dpr = m_skin->devicePixelRatio();
+
+    QString key = (group ? m_groupItems : m_tabItems).at(index).key;
+    key += QLatin1Char('|') + QString::number(rect.width()) + QLatin1Char('x') + QString::number(rect.height())
+        + QLatin1Char('|') + QString::number(m_skinGeneration) + QLatin1Char('|') + QString::number(dpr);
+
+    QPixmap* cached = m_buttonCache.object(key);
+
+    if (cached)
+    {
+        Metrics::self()->recordTabPixmapCacheHit();
+
+        return *cached;
+    }
+
+    Metrics::self()->recordTabPixmapCacheMiss();
+
+    QPixmap pixmap(rect.size() * dpr);
+    pixmap.setDevicePixelRatio(dpr);
+    pixmap.fill(Qt::transparent);
+
+    QPainter painter(&pixmap);
+    painter.setPen(m_skin->tabBarTextColor());
+    painter.translate(-rect.topLeft());
+
+    if (group)
+        drawGroupButton(rect.left(), rect.top(), index, &painter);
+    else
+        drawButton(rect.left(), rect.top(), index, &painter);
+
+    painter.end();
+
+    // Cost in kilobytes, against the limit set in the constructor.
+    m_buttonCache.insert(key, new QPixmap(pixmap), qMax(1, pixmap.width() * pixmap.height() * 4 / 1024));
+
+    return pixmap;
+}
+
+QString TabBar::groupButtonTitle(int index)
 {
-    QString title;
-    int sessionId;
-    bool selected;
-    QFont font = QFontDatabase::systemFont(QFontDatabase::GeneralFont);
-    int textWidth = 0;
+    const TabGroup &group = m_model.group(index);
+
+    int pending = 0;
+    if (!m_pendingSessions.isEmpty())
+    {
+        for (int sessionId : group.tabs)
+            if (m_pendingSessions.contains(sessionId)) ++pending;
+    }
+
+    if (pending)
+        return QString(QStringLiteral("%1 (%2/%3)")).arg(group.title,
+            QString::number(group.tabs.count() - pending), QString::number(group.tabs.count()));
+
+    return QString(QStringLiteral("%1 (%2)")).arg(group.title,QString::number(group.tabs.count()));
+}
 
+int TabBar::drawButton(int x, int y, int index, QPainter* painter)
+{
+    // Without a painter this only advances x, which is how buildLayout() measures the buttons.
     DECLARE_CURRENT_GROUP
-    sessionId = m_tabs.at(index);
-    selected = (sessionId == m_selectedSessionId);
-    title = m_tabTitles[sessionId];
+    int sessionId = m_tabs.at(index);
+    bool selected = (sessionId == m_selectedSessionId);
+    const StripItem& item = m_tabItems.at(index);
+    int textWidth = item.textWidth;
+    int selectedIndex = m_selectedTabIndex;
 
     if (selected)
     {
-        painter.drawPixmap(x, y, m_skin->tabBarSelectedLeftCornerImage());
-        x += m_skin->tabBarSelectedLeftCornerImage().width();
+        if (painter) painter->drawPixmap(x, y, m_skin->tabBarSelectedLeftCornerImage());
+        x += Skin::imageSize(m_skin->tabBarSelectedLeftCornerImage()).width();
     }
     else if (!m_skin->tabBarUnselectedLeftCornerImage().isNull())
     {
-        painter.drawPixmap(x, y, m_skin->tabBarUnselectedLeftCornerImage());
-        x += m_skin->tabBarUnselectedLeftCornerImage().width();
+        if (painter) painter->drawPixmap(x, y, m_skin->tabBarUnselectedLeftCornerImage());
+        x += Skin::imageSize(m_skin->tabBarUnselectedLeftCornerImage()).width();
     }
-    else if (index != m_tabs.indexOf(m_selectedSessionId) + 1)
+    else if (index != selectedIndex + 1)
     {
-        painter.drawPixmap(x, y, m_skin->tabBarSeparatorImage());
-        x += m_skin->tabBarSeparatorImage().width();
+        if (painter) painter->drawPixmap(x, y, m_skin->tabBarSeparatorImage());
+        x += Skin::imageSize(m_skin->tabBarSeparatorImage()).width();
     }
 
-    if (selected) font.setBold(true);
-    else font.setBold(false);
-
-    painter.setFont(font);
-
-    QFontMetrics fontMetrics(font);
-    textWidth = fontMetrics.width(title) + 10;
+    if (painter) painter->setFont(selected ? m_boldFont : m_font);
 
     int h = height()/2;
     // Draw the Prevent Closing image in the tab button.
     if (m_mainWindow->sessionStack()->isSessionClosable(sessionId) == false)
     {
-        if (selected)
-            painter.drawTiledPixmap(x, y,
-                    m_skin->tabBarPreventClosingImagePosition().x() +
-                    m_skin->tabBarPreventClosingImage().width(), h,
-                    m_skin->tabBarSelectedBackgroundImage());
-        else
-            painter.drawTiledPixmap(x, y,
-                    m_skin->tabBarPreventClosingImagePosition().x() +
-                    m_skin->tabBarPreventClosingImage().width(), h,
-                    m_skin->tabBarUnselectedBackgroundImage());
-
-        painter.drawPixmap(x + m_skin->tabBarPreventClosingImagePosition().x(),
-                           m_skin->tabBarPreventClosingImagePosition().y(),
-                           m_skin->tabBarPreventClosingImage());
+        if (painter)
+        {
+            if (selected)
+                painter->drawTiledPixmap(x, y,
+                        m_skin->tabBarPreventClosingImagePosition().x() +
+                        Skin::imageSize(m_skin->tabBarPreventClosingImage()).width(), h,
+                        m_skin->tabBarSelectedBackgroundImage());
+            else
+                painter->drawTiledPixmap(x, y,
+                        m_skin->tabBarPreventClosingImagePosition().x() +
+                        Skin::imageSize(m_skin->tabBarPreventClosingImage()).width(), h,
+                        m_skin->tabBarUnselectedBackgroundImage());
+
+            painter->drawPixmap(x + m_skin->tabBarPreventClosingImagePosition().x(),
+                               m_skin->tabBarPreventClosingImagePosition().y(),
+                               m_skin->tabBarPreventClosingImage());
+        }
 
         x += m_skin->tabBarPreventClosingImagePosition().x();
-        x += m_skin->tabBarPreventClosingImage().width();
+        x += Skin::imageSize(m_skin->tabBarPreventClosingImage()).width();
     }
 
-    if (selected)
-        painter.drawTiledPixmap(x, y, textWidth, h, m_skin->tabBarSelectedBackgroundImage());
-    else
-        painter.drawTiledPixmap(x, y, textWidth, h, m_skin->tabBarUnselectedBackgroundImage());
+    if (painter)
+    {
+        if (selected)
+            painter->drawTiledPixmap(x, y, textWidth, h, m_skin->tabBarSelectedBackgroundImage());
+        else
+            painter->drawTiledPixmap(x, y, textWidth, h, m_skin->tabBarUnselectedBackgroundImage());
 
-    painter.drawText(x, y, textWidth + 1, h + 2, Qt::AlignHCenter | Qt::AlignVCenter, title);
+        painter->drawText(x, y, textWidth + 1, h + 2, Qt::AlignHCenter | Qt::AlignVCenter, item.text);
+    }
 
     x += textWidth;
 
     if (selected)
     {
-        painter.drawPixmap(x, m_skin->tabBarPosition().y(), m_skin->tabBarSelectedRightCornerImage());
-        x += m_skin->tabBarSelectedRightCornerImage().width();
+        if (painter) painter->drawPixmap(x, m_skin->tabBarPosition().y(), m_skin->tabBarSelectedRightCornerImage());
+        x += Skin::imageSize(m_skin->tabBarSelectedRightCornerImage()).width();
     }
     else if (!m_skin->tabBarUnselectedRightCornerImage().isNull())
     {
-        painter.drawPixmap(x, m_skin->tabBarPosition().y(), m_skin->tabBarUnselectedRightCornerImage());
-        x += m_skin->tabBarUnselectedRightCornerImage().width();
+        if (painter) painter->drawPixmap(x, m_skin->tabBarPosition().y(), m_skin->tabBarUnselectedRightCornerImage());
+        x += Skin::imageSize(m_skin->tabBarUnselectedRightCornerImage()).width();
     }
-    else if (index != m_tabs.indexOf(m_selectedSessionId) - 1)
+    else if (index != selectedIndex - 1)
     {
-        painter.drawPixmap(x, m_skin->tabBarPosition().y(), m_skin->tabBarSeparatorImage());
-        x += m_skin->tabBarSeparatorImage().width();
+        if (painter) painter->drawPixmap(x, m_skin->tabBarPosition().y(), m_skin->tabBarSeparatorImage());
+        x += Skin::imageSize(m_skin->tabBarSeparatorImage()).width();
     }
 
     return x;
 }
 
 
-int TabBar::drawGroupButton(int x, int y, int index, QPainter& painter)
+int TabBar::drawGroupButton(int x, int y, int index, QPainter* painter)
 {
-    QString title;
-    bool selected;
-    QFont font = QFontDatabase::systemFont(QFontDatabase::GeneralFont);
-    int textWidth = 0;
-
-    selected = (active_group == index);
-    const TabGroup &group = m_groups.at(index);
-    title = QString(QStringLiteral("%1 (%2)")).arg(group.title,QString::number(group.tabs.count()));
+    // Without a painter this only advances x, which is how buildLayout() measures the buttons.
+    bool selected = (active_group == index);
+    const TabGroup &group = m_model.group(index);
+    const StripItem& item = m_groupItems.at(index);
+    int textWidth = item.textWidth;
 
     if (selected)
     {
-        painter.drawPixmap(x, y, m_skin->tabBarSelectedLeftCornerImage());
-        x += m_skin->tabBarSelectedLeftCornerImage().width();
+        if (painter) painter->drawPixmap(x, y, m_skin->tabBarSelectedLeftCornerImage());
+        x += Skin::imageSize(m_skin->tabBarSelectedLeftCornerImage()).width();
     }
     else if (index != active_group + 1)
     {
-        painter.drawPixmap(x, y, m_skin->tabBarSeparatorImage());
-        x += m_skin->tabBarSeparatorImage().width();
+        if (painter) painter->drawPixmap(x, y, m_skin->tabBarSeparatorImage());
+        x += Skin::imageSize(m_skin->tabBarSeparatorImage()).width();
     }
 
-    if (selected) font.setBold(true);
-    else font.setBold(false);
-
-    painter.setFont(font);
-
-    QFontMetrics fontMetrics(font);
-    textWidth = fontMetrics.width(title) + 10;
+    if (painter) painter->setFont(selected ? m_boldFont : m_font);
 
     int h = height()/2;
 
     if (group.locked == true)
     {
-        if (selected)
-            painter.drawTiledPixmap(x, y,
-                    m_skin->tabBarPreventClosingImagePosition().x() +
-                    m_skin->tabBarPreventClosingImage().width(), h,
-                    m_skin->tabBarSelectedBackgroundImage());
-        else
-            painter.drawTiledPixmap(x, y,
-                    m_skin->tabBarPreventClosingImagePosition().x() +
-                    m_skin->tabBarPreventClosingImage().width(), h,
-                    m_skin->tabBarUnselectedBackgroundImage());
-
-        painter.drawPixmap(x + m_skin->tabBarPreventClosingImagePosition().x(),
-                           h +m_skin->tabBarPreventClosingImagePosition().y(),
-                           m_skin->tabBarPreventClosingImage());
+        if (painter)
+        {
+            if (selected)
+                painter->drawTiledPixmap(x, y,
+                        m_skin->tabBarPreventClosingImagePosition().x() +
+                        Skin::imageSize(m_skin->tabBarPreventClosingImage()).width(), h,
+                        m_skin->tabBarSelectedBackgroundImage());
+            else
+                painter->drawTiledPixmap(x, y,
+                        m_skin->tabBarPreventClosingImagePosition().x() +
+                        Skin::imageSize(m_skin->tabBarPreventClosingImage()).width(), h,
+                        m_skin->tabBarUnselectedBackgroundImage());
+
+            painter->drawPixmap(x + m_skin->tabBarPreventClosingImagePosition().x(),
+                               h +m_skin->tabBarPreventClosingImagePosition().y(),
+                               m_skin->tabBarPreventClosingImage());
+        }
 
         x += m_skin->tabBarPreventClosingImagePosition().x();
-        x += m_skin->tabBarPreventClosingImage().width();
+        x += Skin::imageSize(m_skin->tabBarPreventClosingImage()).width();
     }
 
-    if (selected)
-        painter.drawTiledPixmap(x, y, textWidth, h, m_skin->tabBarSelectedBackgroundImage());
-    else
-        painter.drawTiledPixmap(x, y, textWidth, h, m_skin->tabBarUnselectedBackgroundImage());
+    if (painter)
+    {
+        if (selected)
+            painter->drawTiledPixmap(x, y, textWidth, h, m_skin->tabBarSelectedBackgroundImage());
+        else
+            painter->drawTiledPixmap(x, y, textWidth, h, m_skin->tabBarUnselectedBackgroundImage());
 
-    painter.drawText(x, y, textWidth + 1, h + 2, Qt::AlignHCenter | Qt::AlignVCenter, title);
+        painter->drawText(x, y, textWidth + 1, h + 2, Qt::AlignHCenter | Qt::AlignVCenter, item.text);
+    }
 
     x += textWidth;
 
     if (selected)
     {
-        painter.drawPixmap(x, m_skin->tabBarPosition().y(), m_skin->tabBarSelectedRightCornerImage());
-        x += m_skin->tabBarSelectedRightCornerImage().width();
+        if (painter) painter->drawPixmap(x, m_skin->tabBarPosition().y(), m_skin->tabBarSelectedRightCornerImage());
+        x += Skin::imageSize(m_skin->tabBarSelectedRightCornerImage()).width();
     }
     else if (index != active_group + 1)
     {
-        painter.drawPixmap(x, m_skin->tabBarPosition().y(), m_skin->tabBarSeparatorImage());
-        x += m_skin->tabBarSeparatorImage().width();
+        if (painter) painter->drawPixmap(x, m_skin->tabBarPosition().y(), m_skin->tabBarSeparatorImage());
+        x += Skin::imageSize(m_skin->tabBarSeparatorImage()).width();
     }
 
     return x;
 }
 
+int TabBar::itemAt(const QVector<StripItem>& items, int x)
+{
+    // x is in strip coordinates, i.e. with the scroll offset already added.
+    if (x <= m_skin->tabBarPosition().x()) return -1;
+
+    // Items are laid out left to right, so the first one ending past x is the one under it.
+    QVector<StripItem>::const_iterator it = std::upper_bound(items.constBegin(), items.constEnd(), x,
+        [](int x, const StripItem& item) { return x < item.right; });
+
+    if (it == items.constEnd()) return -1;
+
+    return it - items.constBegin();
+}
+
+int TabBar::overflowIndicatorAt(bool group, int x)
+{
+    const QVector<StripItem>& items = group ? m_groupItems : m_tabItems;
+    int scroll = group ? m_groupScroll : m_tabScroll;
+    QRect row = group ? groupRowRect() : tabRowRect();
+
+    if (scroll > 0 && x >= row.left() && x <= leftIndicatorRect(row).right())
+        return -1;
+
+    if (scroll < maxScroll(items, row) && x >= rightIndicatorRect(row).left() && x <= row.right())
+        return 1;
+
+    return 0;
+}
+
 int TabBar::tabAt(int x)
 {
-    for (int index = 0; index < m_tabWidths.count(); ++index)
-    {
-        if (x >  m_skin->tabBarPosition().x() && x < m_tabWidths.at(index))
-            return index;
-    }
+    updateLayout();
+
+    if (x > tabRowRect().right() || overflowIndicatorAt(false, x)) return -1;
 
-    return -1;
+    return itemAt(m_tabItems, x + m_tabScroll);
 }
 
 int TabBar::groupAt(int x)
 {
-    for (int index = 0; index < m_groupWidths.count(); ++index)
-    {
-        if (x >  m_skin->tabBarPosition().x() && x < m_groupWidths.at(index))
-            return index;
-    }
+    updateLayout();
+
+    if (x > groupRowRect().right() || overflowIndicatorAt(true, x)) return -1;
 
-    return -1;
+    return itemAt(m_groupItems, x + m_groupScroll);
 }
 
 void TabBar::wheelEvent(QWheelEvent* event)
 {
+    // Horizontal or shifted wheel events scroll the strip without switching tabs.
+    if (event->orientation() == Qt::Horizontal || event->modifiers() & Qt::ShiftModifier)
+    {
+        scrollStrip(event->y() > height()/2, -event->delta() / 2);
+        return;
+    }
+
     if (event->delta() < 0)
         selectNextTab();
     else
@@ -814,6 +1578,14 @@ void TabBar::mousePressEvent(QMouseEvent* event)
 
     m_mousePressed4Group = event->y() > height()/2;
 
+    int indicator = overflowIndicatorAt(m_mousePressed4Group, event->x());
+    if (indicator != 0 && event->button() == Qt::LeftButton)
+    {
+        QRect row = m_mousePressed4Group ? groupRowRect() : tabRowRect();
+        scrollStrip(m_mousePressed4Group, indicator * row.width() / 2);
+        return;
+    }
+
     int index = m_mousePressed4Group ? groupAt(event->x()) : tabAt(event->x());
     if (index == -1) return;
 
@@ -823,7 +1595,7 @@ void TabBar::mousePressEvent(QMouseEvent* event)
         if(!m_mousePressed4Group)
         {
             DECLARE_CURRENT_GROUP
-            if (index != m_tabs.indexOf(m_selectedSessionId) || event->button() == Qt::MidButton)
+            if (index != tabIndex(m_selectedSessionId) || event->button() == Qt::MidButton)
             {
                 m_mousePressed = true;
                 m_mousePressedIndex = index;
@@ -855,7 +1627,7 @@ void TabBar::mouseReleaseEvent(QMouseEvent* event)
     {
         if(!m_mousePressed4Group) {
             DECLARE_CURRENT_GROUP
-            if (event->button() == Qt::LeftButton && index != m_tabs.indexOf(m_selectedSessionId))
+            if (event->button() == Qt::LeftButton && index != tabIndex(m_selectedSessionId))
                 emit tabSelected(m_tabs.at(index));
 
             if (event->button() == Qt::MidButton)
@@ -863,7 +1635,6 @@ void TabBar::mouseReleaseEvent(QMouseEvent* event)
         } else {
             if (event->button() == Qt::LeftButton && index != active_group){
                 selectGroup(index);
-                repaint();
             }
         }
     }
@@ -958,7 +1729,7 @@ void TabBar::dropEvent(QDropEvent* event)
         DECLARE_CURRENT_GROUP
         int targetIndex = dropIndex(event->pos());
         int sourceSessionId = event->mimeData()->text().toInt();
-        int sourceIndex = m_tabs.indexOf(sourceSessionId);
+        int sourceIndex = tabIndex(sourceSessionId);
 
         if (targetIndex == -1)
             targetIndex = m_tabs.count() - 1;
@@ -967,7 +1738,9 @@ void TabBar::dropEvent(QDropEvent* event)
         else if (sourceIndex < targetIndex)
             --targetIndex;
 
-        m_tabs.move(sourceIndex, targetIndex);
+        m_model.moveTab(sourceSessionId, active_group, targetIndex);
+        m_journal->moveTab(sourceSessionId, active_group, targetIndex);
+        invalidateLayout();
         emit tabSelected(m_tabs.at(targetIndex));
 
         event->accept();
@@ -987,18 +1760,20 @@ void TabBar::mouseDoubleClickEvent(QMouseEvent* event)
 
     int index = m_mousePressed4Group ? groupAt(event->x()) : tabAt(event->x());
 
-    if (event->button() == Qt::LeftButton)
+    if (event->button() == Qt::LeftButton && !overflowIndicatorAt(m_mousePressed4Group, event->x()))
     {
         if(m_mousePressed4Group){
-            if (event->x() <= m_groupWidths.last())
+            if (event->x() <= m_groupItems.last().right - m_groupScroll)
                 interactiveGroupRename(index);
-            else if (event->x() > m_groupWidths.last())
+            else if (event->x() > m_groupItems.last().right - m_groupScroll)
                 addGroup();
         } else {
             DECLARE_CURRENT_GROUP
-            if (event->x() <= m_tabWidths.last())
-                interactiveRename(m_tabs.at(index));
-            else if (event->x() > m_tabWidths.last())
+            if (event->x() <= m_tabItems.last().right - m_tabScroll)
+            {
+                if (index != -1) interactiveRename(m_tabs.at(index));
+            }
+            else if (event->x() > m_tabItems.last().right - m_tabScroll)
                 emit newTabRequested();
         }
     }
@@ -1017,19 +1792,18 @@ void TabBar::leaveEvent(QEvent* event)
 
 void TabBar::addTab(int sessionId, const QString& title)
 {
-    if(m_groups.empty()){
+    if(m_model.isEmpty()){
         _addGroup();
     }
 
-    DECLARE_CURRENT_GROUP
-    m_tabs.append(sessionId);
+    m_model.appendTab(active_group, sessionId, title.isEmpty() ? standardTabTitle() : title);
+    m_journal->addTab(active_group, sessionId);
+    indexTab(sessionId);
 
-    if (title.isEmpty())
-        m_tabTitles.insert(sessionId, standardTabTitle());
-    else
-        m_tabTitles.insert(sessionId, title);
+    invalidateLayout();
 
-    emit tabSelected(sessionId);
+    if (!m_restoringLayout)
+        emit tabSelected(sessionId);
 }
 
 void TabBar::removeTab(int sessionId)
@@ -1037,18 +1811,27 @@ void TabBar::removeTab(int sessionId)
     DECLARE_CURRENT_GROUP
     if (sessionId == -1) sessionId = m_selectedSessionId;
     if (sessionId == -1) return;
-    if (!m_tabs.contains(sessionId)) return;
 
-    int index = m_tabs.indexOf(sessionId);
+    m_layoutTabNames.remove(sessionId);
+
+    if (!m_model.contains(sessionId)) return;
+
+    if (m_model.groupOf(sessionId) != active_group)
+    {
+        removeBackgroundTab(sessionId);
+        return;
+    }
 
     if (m_lineEdit->isVisible() && sessionId == m_renamingIndex)
         m_lineEdit->hide();
 
-    m_tabs.removeAt(index);
-    m_tabTitles.remove(sessionId);
+    m_model.removeTab(sessionId);
+    m_journal->removeTab(sessionId);
+    m_switchIndex.remove(sessionId);
+    invalidateLayout();
 
     if ((m_tabs.count() == 0))
-        if(m_groups.count()==1 || m_groups[active_group].locked)
+        if(m_model.groupCount()==1 || (m_model.group(active_group).locked && !m_model.group(active_group).remove_when_empty))
             emit lastTabClosed();
         else
             closeGroup();
@@ -1056,22 +1839,43 @@ void TabBar::removeTab(int sessionId)
         emit tabSelected(m_tabs.last());
 }
 
+void TabBar::removeBackgroundTab(int sessionId)
+{
+    int group_id = m_model.removeTab(sessionId);
+    if(group_id == -1) return;
+
+    m_journal->removeTab(sessionId);
+    m_switchIndex.remove(sessionId);
+
+    const TabGroup &group = m_model.group(group_id);
+    if(group.tabs.empty() && (!group.locked || group.remove_when_empty)) {
+        m_model.removeGroup(group_id);
+        m_journal->removeGroup(group_id);
+        if(active_group > group_id)
+            active_group--;
+    }
+
+    invalidateLayout();
+}
+
 void TabBar::interactiveRename(int sessionId)
 {
     DECLARE_CURRENT_GROUP
 
     if (sessionId == -1) return;
-    if (!m_tabs.contains(sessionId)) return;
+    if (tabIndex(sessionId) == -1) return;
 
     m_renamingIndex = sessionId;
 
-    int index = m_tabs.indexOf(sessionId);
-    int x = index ? m_tabWidths.at(index - 1) : m_skin->tabBarPosition().x();
+    updateLayout();
+
+    int index = tabIndex(sessionId);
+    int x = m_tabItems.at(index).left - m_tabScroll;
     int y = m_skin->tabBarPosition().y();
-    int width = m_tabWidths.at(index) - x;
+    int width = m_tabItems.at(index).right - m_tabItems.at(index).left;
 
     interactiveRename4Group = false;
-    m_lineEdit->setText(m_tabTitles[sessionId]);
+    m_lineEdit->setText(m_model.tabTitle(sessionId));
     m_lineEdit->setGeometry(x-1, y-1, width+3, height()/2+2);
     m_lineEdit->selectAll();
     m_lineEdit->setFocus();
@@ -1080,18 +1884,20 @@ void TabBar::interactiveRename(int sessionId)
 
 void TabBar::interactiveGroupRename(int group_id)
 {
-    if (group_id < 0 || group_id > m_groups.count()) return;
+    if (group_id < 0 || group_id >= m_model.groupCount()) return;
 
     m_renamingIndex = group_id;
 
     m_renamingSessionId = -1;
+    updateLayout();
+
     int half_height = height()/2;
-    int x = group_id ? m_groupWidths.at(group_id - 1) : m_skin->tabBarPosition().x();
+    int x = m_groupItems.at(group_id).left - m_groupScroll;
     int y = m_skin->tabBarPosition().y() + half_height;
-    int width = m_groupWidths.at(group_id) - x;
+    int width = m_groupItems.at(group_id).right - m_groupItems.at(group_id).left;
 
     interactiveRename4Group = true;
-    m_lineEdit->setText(m_groups[group_id].title);
+    m_lineEdit->setText(m_model.group(group_id).title);
     m_lineEdit->setGeometry(x-1, y-1, width+3, half_height+2);
     m_lineEdit->selectAll();
     m_lineEdit->setFocus();
@@ -1109,25 +1915,25 @@ void TabBar::interactiveRenameDone()
 
 void TabBar::selectTab(int sessionId)
 {
-    DECLARE_CURRENT_GROUP
-
-    if (!m_tabs.contains(sessionId)) return;
+    if (tabIndex(sessionId) == -1) return;
 
     m_selectedSessionId = sessionId;
 
-    int tab_index = m_tabs.indexOf(sessionId);
-    m_groups[active_group].selected_tab = tab_index;
+    int tab_index = m_model.indexOf(sessionId);
+    m_model.setSelectedTab(active_group, tab_index);
+    m_journal->selectTab(sessionId);
     updateMoveActions(tab_index);
 
     updateToggleActions(sessionId);
 
-    repaint();
+    m_revealSelection = true;
+    invalidateLayout();
 }
 
 void TabBar::selectNextTab()
 {
     DECLARE_CURRENT_GROUP
-    int index = m_tabs.indexOf(m_selectedSessionId);
+    int index = tabIndex(m_selectedSessionId);
     int newSelectedSessionId = m_selectedSessionId;
 
     if (index == -1)
@@ -1143,7 +1949,7 @@ void TabBar::selectNextTab()
 void TabBar::selectPreviousTab()
 {
     DECLARE_CURRENT_GROUP
-    int index = m_tabs.indexOf(m_selectedSessionId);
+    int index = tabIndex(m_selectedSessionId);
     int newSelectedSessionId = m_selectedSessionId;
 
     if (index == -1)
@@ -1158,7 +1964,7 @@ void TabBar::selectPreviousTab()
 
 void TabBar::selectNextGroup()
 {
-    if (active_group == m_groups.count() - 1)
+    if (active_group == m_model.groupCount() - 1)
         selectGroup(0);
     else
         selectGroup(active_group+1);
@@ -1167,23 +1973,24 @@ void TabBar::selectNextGroup()
 void TabBar::selectPreviousGroup()
 {
     if (active_group == 0)
-        selectGroup(m_groups.count() -1);
+        selectGroup(m_model.groupCount() -1);
     else
         selectGroup(active_group -1);
 }
 
 void TabBar::moveTabLeft(int sessionId)
 {
-    DECLARE_CURRENT_GROUP
     if (sessionId == -1) sessionId = m_selectedSessionId;
+    if (tabIndex(sessionId) == -1) return;
 
-    int index = m_tabs.indexOf(sessionId);
+    int index = m_model.indexOf(sessionId);
 
     if (index < 1) return;
 
-    m_tabs.swap(index, index - 1);
+    m_model.moveTab(sessionId, active_group, index - 1);
+    m_journal->moveTab(sessionId, active_group, index - 1);
 
-    repaint();
+    invalidateLayout();
 
     updateMoveActions(index - 1);
 }
@@ -1191,60 +1998,65 @@ void TabBar::moveTabLeft(int sessionId)
 void TabBar::moveTabRight(int sessionId)
 {
     if (sessionId == -1) sessionId = m_selectedSessionId;
+    if (tabIndex(sessionId) == -1) return;
+
     DECLARE_CURRENT_GROUP
-    int index = m_tabs.indexOf(sessionId);
+    int index = m_model.indexOf(sessionId);
 
-    if (index == -1 || index == m_tabs.count() - 1) return;
+    if (index == m_tabs.count() - 1) return;
 
-    m_tabs.swap(index, index + 1);
+    m_model.moveTab(sessionId, active_group, index + 1);
+    m_journal->moveTab(sessionId, active_group, index + 1);
 
-    repaint();
+    invalidateLayout();
 
     updateMoveActions(index + 1);
 }
 
 void TabBar::moveTabLeftGroup(int sessionId)
 {
-    if(m_groups.size() == 1) return;
+    if(m_model.groupCount() == 1) return;
     if (sessionId == -1) sessionId = m_selectedSessionId;
+    if (tabIndex(sessionId) == -1) return;
 
-    auto &active_tab_group = m_groups[active_group];
-    auto dst_group_index = active_group==0 ? m_groups.size()-1 : active_group-1;
-    auto &dst_tab_group = m_groups[dst_group_index];
-    auto active_tab_index = active_tab_group.tabs.indexOf(sessionId);
+    int dst_group_index = active_group==0 ? m_model.groupCount()-1 : active_group-1;
+    int dst_tab_index = m_model.tabs(dst_group_index).count();
 
-    dst_tab_group.tabs.push_back(active_tab_group.tabs[active_tab_index]);
-    dst_tab_group.selected_tab = dst_tab_group.tabs.size()-1;
+    m_model.moveTab(sessionId, dst_group_index, dst_tab_index);
+    m_model.setSelectedTab(dst_group_index, dst_tab_index);
+    m_journal->moveTab(sessionId, dst_group_index, dst_tab_index);
+    indexTab(sessionId);
 
-    active_tab_group.tabs.removeAt(active_tab_index);
+    const TabGroup &active_tab_group = m_model.group(active_group);
     if(active_tab_group.selected_tab > active_tab_group.tabs.size() - 1)
-        active_tab_group.selected_tab = active_tab_group.tabs.size() - 1;
+        m_model.setSelectedTab(active_group, active_tab_group.tabs.size() - 1);
 
     selectGroup(dst_group_index);
 
-    repaint();
+    invalidateLayout();
 }
 
 void TabBar::moveTabRightGroup(int sessionId)
 {
-    if(m_groups.size() == 1) return;
+    if(m_model.groupCount() == 1) return;
     if (sessionId == -1) sessionId = m_selectedSessionId;
+    if (tabIndex(sessionId) == -1) return;
 
-    auto &active_tab_group = m_groups[active_group];
-    auto dst_group_index = active_group >= (m_groups.size()-1) ? 0 : active_group + 1;
-    auto &dst_tab_group = m_groups[dst_group_index];
-    auto active_tab_index = active_tab_group.tabs.indexOf(sessionId);
+    int dst_group_index = active_group >= (m_model.groupCount()-1) ? 0 : active_group + 1;
+    int dst_tab_index = m_model.tabs(dst_group_index).count();
 
-    dst_tab_group.tabs.push_back(active_tab_group.tabs[active_tab_index]);
-    dst_tab_group.selected_tab = dst_tab_group.tabs.size()-1;
+    m_model.moveTab(sessionId, dst_group_index, dst_tab_index);
+    m_model.setSelectedTab(dst_group_index, dst_tab_index);
+    m_journal->moveTab(sessionId, dst_group_index, dst_tab_index);
+    indexTab(sessionId);
 
-    active_tab_group.tabs.removeAt(active_tab_index);
+    const TabGroup &active_tab_group = m_model.group(active_group);
     if(active_tab_group.selected_tab > active_tab_group.tabs.size() - 1)
-        active_tab_group.selected_tab = active_tab_group.tabs.size() - 1;
+        m_model.setSelectedTab(active_group, active_tab_group.tabs.size() - 1);
 
     selectGroup(dst_group_index);
 
-    repaint();
+    invalidateLayout();
 }
 
 void TabBar::moveGroupLeft(int group_id)
@@ -1252,21 +2064,23 @@ void TabBar::moveGroupLeft(int group_id)
     if(group_id == -1 ) group_id = active_group;
     if(group_id < 1) return;
 
-    m_groups.swap(group_id,group_id-1);
+    m_model.swapGroups(group_id,group_id-1);
+    m_journal->moveGroup(group_id, group_id-1);
     selectGroup(group_id-1);
 
-    repaint();
+    invalidateLayout();
 }
 
 void TabBar::moveGroupRight(int group_id)
 {
     if(group_id == -1 ) group_id = active_group;
-    if(group_id < 0 || group_id == m_groups.count() - 1) return;
+    if(group_id < 0 || group_id == m_model.groupCount() - 1) return;
 
-    m_groups.swap(group_id,group_id+1);
+    m_model.swapGroups(group_id,group_id+1);
+    m_journal->moveGroup(group_id, group_id+1);
     selectGroup(group_id+1);
 
-    repaint();
+    invalidateLayout();
 }
 
 void TabBar::closeTabButtonClicked()
@@ -1274,50 +2088,107 @@ void TabBar::closeTabButtonClicked()
     emit tabClosed(m_selectedSessionId);
 }
 
+void TabBar::updateTab(int sessionId)
+{
+    if (!m_model.contains(sessionId)) return;
+
+    invalidateLayout();
+}
+
 QString TabBar::tabTitle(int sessionId)
 {
-    if (m_tabTitles.contains(sessionId))
-        return m_tabTitles[sessionId];
-    else
-        return QString();
+    return m_model.tabTitle(sessionId);
 }
 
 void TabBar::setTabTitle(int sessionId, const QString& newTitle)
 {
     if (sessionId == -1) return;
-    if (!m_tabTitles.contains(sessionId)) return;
+    if (!m_model.contains(sessionId)) return;
     if (m_tabTitlesSetInteractive.value(sessionId, false)) return;
+    if (newTitle.isEmpty() || m_model.tabTitle(sessionId) == newTitle) return;
 
-    if (!newTitle.isEmpty())
-        m_tabTitles[sessionId] = newTitle;
+    m_model.setTabTitle(sessionId, newTitle);
+    indexTab(sessionId);
 
-    update();
+    invalidateLayout();
 }
 
 void TabBar::setTabTitleInteractive(int sessionId, const QString& newTitle)
 {
     if (sessionId == -1) return;
-    if (!m_tabTitles.contains(sessionId)) return;
+    if (!m_model.contains(sessionId)) return;
 
     if (!newTitle.isEmpty())
     {
-        m_tabTitles[sessionId] = newTitle;
+        m_model.setTabTitle(sessionId, newTitle);
         m_tabTitlesSetInteractive[sessionId] = true;
+        indexTab(sessionId);
     }
     else
         m_tabTitlesSetInteractive.remove(sessionId);
 
-    update();
+    m_journal->setTabTitle(sessionId, newTitle);
+
+    invalidateLayout();
 }
 
 void TabBar::setGroupTitle(int group_id, const QString& newTitle)
 {
-    if (group_id < 0 || group_id > m_groups.count()) return;
+    if (group_id < 0 || group_id >= m_model.groupCount()) return;
 
     if (!newTitle.isEmpty())
-        m_groups[group_id].title = newTitle;
+    {
+        m_model.setGroupTitle(group_id, newTitle);
+        m_journal->setGroupTitle(group_id, newTitle);
+        indexGroup(group_id);
+    }
 
-    update();
+    invalidateLayout();
+}
+
+int TabBar::tabIndex(int sessionId)
+{
+    if (!m_model.contains(sessionId) || m_model.groupOf(sessionId) != active_group) return -1;
+
+    return m_model.indexOf(sessionId);
+}
+
+void TabBar::indexTab(int sessionId)
+{
+    m_switchIndex.setTab(sessionId, m_model.tabTitle(sessionId), m_model.group(m_model.groupOf(sessionId)).title);
+}
+
+void TabBar::indexGroup(int group_id)
+{
+    foreach (int sessionId, m_model.tabs(group_id))
+        indexTab(sessionId);
+}
+
+void TabBar::openQuickSwitcher()
+{
+    // Foreground commands change without telling anyone, so they are only looked
+    // up when the switcher is about to show them.
+    SessionStack* sessionStack = m_mainWindow->sessionStack();
+
+    foreach (int sessionId, m_switchIndex.sessionIds())
+        m_switchIndex.setCommand(sessionId, sessionStack->foregroundProcessName(sessionId));
+
+    m_quickSwitcher->popup(m_mainWindow->geometry());
+}
+
+void TabBar::jumpToSession(int sessionId)
+{
+    if (!m_model.contains(sessionId)) return;
+
+    int group_id = m_model.groupOf(sessionId);
+
+    if (group_id != active_group)
+    {
+        m_model.setSelectedTab(group_id, m_model.indexOf(sessionId));
+        selectGroup(group_id);
+    }
+    else
+        emit tabSelected(sessionId);
 }
 
 int TabBar::sessionAtTab(int index)
@@ -1331,12 +2202,9 @@ int TabBar::sessionAtTab(int index)
 
 void TabBar::_addGroup(const QString& title, bool locked)
 {
-    if(title.isEmpty())
-        m_groups.append(TabGroup(standardGroupTitle(),locked));
-    else
-        m_groups.append(TabGroup(title,locked));
-
-    active_group = m_groups.size()-1;
+    active_group = m_model.appendGroup(title.isEmpty() ? standardGroupTitle() : title, locked);
+    m_journal->addGroup(m_model.group(active_group).title, locked);
+    invalidateLayout();
     updateGroupToggleActions(active_group);
 }
 
@@ -1350,23 +2218,26 @@ void TabBar::closeGroup()
 {
     int next_group;
 
-    if(m_groups.count() < 2) return;
+    if(m_model.groupCount() < 2) return;
 
-    //QList<int> *grp_ptr = &m_groups[active_group];
-    TabGroup &group = m_groups[active_group];
-    if(group.locked) return;
+    const TabGroup &group = m_model.group(active_group);
+    if(group.locked && !group.remove_when_empty) return;
 
     QList<int> m_tabs(group.tabs);
 
-    if(active_group == m_groups.count()-1){
+    if(active_group == m_model.groupCount()-1){
         next_group = active_group-1;
     } else {
         next_group = active_group;
     }
 
+    foreach (int sessionId, m_tabs)
+        m_switchIndex.remove(sessionId);
+
     setUpdatesEnabled(false);
-    m_groups.removeAt(active_group);
-    m_groupWidths.removeAt(active_group);
+    m_model.removeGroup(active_group);
+    m_journal->removeGroup(active_group);
+    invalidateLayout();
     selectGroup(next_group);
     setUpdatesEnabled(true);
 
@@ -1378,45 +2249,24 @@ void TabBar::closeGroup()
 
 void TabBar::selectGroup(int group_id){
     active_group = group_id;
+    m_journal->selectGroup(group_id);
+    m_revealSelection = true;
+    invalidateLayout();
     updateGroupToggleActions(group_id);
     DECLARE_CURRENT_GROUP
     if(!m_tabs.count())
         emit newTabRequested();
     else
-        emit tabSelected(m_tabs.at(m_groups[active_group].selected_tab));
+        emit tabSelected(m_tabs.at(m_model.group(active_group).selected_tab));
 }
 
 QString TabBar::standardTabTitle()
 {
     QString newTitle = makeTabTitle(0);
-
-    bool nameOk;
     int count = 0;
 
-    do
-    {
-        nameOk = true;
-
-        QHashIterator<int, QString> it(m_tabTitles);
-
-        while (it.hasNext())
-        {
-            it.next();
-
-            if (newTitle == it.value())
-            {
-                nameOk = false;
-                break;
-            }
-        }
-
-        if (!nameOk)
-        {
-            count++;
-            newTitle = makeTabTitle(count);
-        }
-    }
-    while (!nameOk);
+    while (m_model.hasTabTitle(newTitle))
+        newTitle = makeTabTitle(++count);
 
     return newTitle;
 }
@@ -1436,30 +2286,10 @@ QString TabBar::makeTabTitle(int id)
 QString TabBar::standardGroupTitle()
 {
     QString newTitle = makeGroupTitle(0);
-
-    bool nameOk;
     int count = 0;
 
-    do
-    {
-        nameOk = true;
-        QListIterator<TabGroup> it(m_groups);
-        for(int index = 0; index < m_groups.count();index++)
-        {
-            if (newTitle == m_groups[index].title)
-            {
-                nameOk = false;
-                break;
-            }
-        }
-
-        if (!nameOk)
-        {
-            count++;
-            newTitle = makeGroupTitle(count);
-        }
-    }
-    while (!nameOk);
+    while (m_model.hasGroupTitle(newTitle))
+        newTitle = makeGroupTitle(++count);
 
     return newTitle;
 }
@@ -1483,8 +2313,9 @@ void TabBar::startDrag(int index)
     m_startPos.setX(0);
     m_startPos.setY(0);
 
-    int x = index ? m_tabWidths.at(index - 1) : m_skin->tabBarPosition().x();
-    int tabWidth = m_tabWidths.at(index) - x;
+    updateLayout();
+
+    int tabWidth = m_tabItems.at(index).right - m_tabItems.at(index).left;
     QString title = tabTitle(sessionId);
 
     QPixmap tab(tabWidth, height());
@@ -1499,7 +2330,7 @@ void TabBar::startDrag(int index)
     painter.initFrom(this);
     painter.setPen(m_skin->tabBarTextColor());
 
-    drawButton(0, 0, index, painter);
+    drawButton(0, 0, index, &painter);
     painter.end();
 
     QMimeData* mimeData = new QMimeData;
@@ -1538,8 +2369,10 @@ void TabBar::drawDropIndicator(int index, bool disabled)
     else
         temp_index = index;
 
-    int x = temp_index ? m_tabWidths.at(temp_index - 1) : m_skin->tabBarPosition().x();
-    int tabWidth = m_tabWidths.at(temp_index) - x;
+    updateLayout();
+
+    int x = m_tabItems.at(temp_index).left - m_tabScroll;
+    int tabWidth = m_tabItems.at(temp_index).right - m_tabItems.at(temp_index).left;
     int y = m_skin->tabBarPosition().y();
 
     m_dropRect = QRect(x, y - height(), tabWidth, height() - y);
@@ -1564,8 +2397,8 @@ int TabBar::dropIndex(const QPoint pos)
     if (index < 0)
         return index;
 
-    int x = index ? m_tabWidths.at(index - 1) : m_skin->tabBarPosition().x();
-    int tabWidth = m_tabWidths.at(index) - x;
+    int x = m_tabItems.at(index).left - m_tabScroll;
+    int tabWidth = m_tabItems.at(index).right - m_tabItems.at(index).left;
     int y = m_skin->tabBarPosition().y();
     m_dropRect = QRect(x, y - height(), tabWidth, height() - y);
 
@@ -1584,7 +2417,7 @@ bool TabBar::isSameTab(const QDropEvent* event)
     DECLARE_CURRENT_GROUP
     int index = dropIndex(event->pos());
     int sourceSessionId = event->mimeData()->text().toInt();
-    int sourceIndex = m_tabs.indexOf(sourceSessionId);
+    int sourceIndex = tabIndex(sourceSessionId);
 
     bool isLastTab = (sourceIndex == m_tabs.count()-1) && (index == -1);
 
@@ -23,26 +23,32 @@
 #ifndef TABBAR_H
 #define TABBAR_H
 
+#include "layoutconfig.h"
+#include "quickswitchindex.h"
+#include "tabmodel.h"
+
+#include <QCache>
+#include <QDateTime>
+#include <QFont>
 #include <QList>
 #include <QHash>
+#include <QPixmap>
+#include <QSet>
+#include <QStyle>
+#include <QVector>
 #include <QWidget>
 
 class MainWindow;
+class QuickSwitcher;
+class SessionJournal;
 class Skin;
+class SkinButton;
 
+class QFileSystemWatcher;
 class QLineEdit;
 class QMenu;
-class QPushButton;
-class QToolButton;
 class QLabel;
-
-struct TabGroup {
-    QList<int> tabs;
-    QString title;
-    bool locked;
-    int selected_tab;
-    TabGroup(const QString &t, bool is_locked = false);
-};
+class QTimer;
 
 class TabBar : public QWidget
 {
@@ -58,6 +64,9 @@ class TabBar : public QWidget
 
         void restoreGroupsFromSettings();
 
+        SessionJournal* journal() { return m_journal; }
+        void applySettings();
+
     public Q_SLOTS:
         void addTab(int sessionId, const QString& title);
         void removeTab(int sessionId = -1);
@@ -91,6 +100,13 @@ class TabBar : public QWidget
         void closeGroup();
         void selectGroup(int group_id);
 
+        void updateTab(int sessionId);
+
+        void scrollTabsLeft();
+        void scrollTabsRight();
+
+        void openQuickSwitcher();
+
     Q_SIGNALS:
         void newTabRequested();
         void tabSelected(int sessionId);
@@ -104,6 +120,7 @@ class TabBar : public QWidget
 
     protected:
         virtual void resizeEvent(QResizeEvent*);
+        virtual void changeEvent(QEvent*);
         virtual void paintEvent(QPaintEvent*);
         virtual void wheelEvent(QWheelEvent*);
         virtual void keyPressEvent(QKeyEvent*);
@@ -130,15 +147,56 @@ class TabBar : public QWidget
 
         void interactiveRenameDone();
 
+        void checkLayoutFile();
+        void reloadLayout();
+
+        void realizeNextSession();
+
+        void updateLayout();
+
+        void jumpToSession(int sessionId);
+
 
     private:
         QString standardTabTitle();
         QString makeTabTitle(int number);
         QString standardGroupTitle();
         QString makeGroupTitle(int number);
+        int tabIndex(int sessionId);
         int tabAt(int x);
         int groupAt(int x);
 
+        struct StripItem
+        {
+            QString key;
+            QString text;
+            int textWidth;
+            int left;
+            int right;
+        };
+
+        void invalidateLayout();
+        void buildLayout();
+        QRegion changedItems(const QVector<StripItem>& oldItems, const QVector<StripItem>& newItems,
+            const QRect& row, int oldScroll, int scroll);
+        QRect tabRowRect();
+        QRect groupRowRect();
+        QRect itemRect(const StripItem& item, const QRect& row, int scroll);
+        void paintRow(QPainter& painter, bool group, const QRect& row, const QRegion& region);
+        void drawOverflowIndicator(QPainter& painter, QStyle::PrimitiveElement arrow, const QRect& rect);
+        QRect leftIndicatorRect(const QRect& row);
+        QRect rightIndicatorRect(const QRect& row);
+        int overflowIndicatorAt(bool group, int x);
+        int maxScroll(const QVector<StripItem>& items, const QRect& row);
+        void revealItem(const QVector<StripItem>& items, int index, int& scroll, const QRect& row);
+        void scrollStrip(bool group, int delta);
+        QString groupButtonTitle(int index);
+        QPixmap buttonPixmap(int index, bool group, const QRect& rect);
+        int itemAt(const QVector<StripItem>& items, int x);
+
+        void indexTab(int sessionId);
+        void indexGroup(int group_id);
+
         void readyTabContextMenu();
         void readyGroupContextMenu();
 
@@ -149,8 +207,8 @@ class TabBar : public QWidget
         void updateToggleMonitorSilenceMenu(int sessionId = -1);
         void updateToggleMonitorActivityMenu(int sessionId = -1);
 
-        int drawButton(int x, int y, int index, QPainter& painter);
-        int drawGroupButton(int x, int y, int index, QPainter& painter);
+        int drawButton(int x, int y, int index, QPainter* painter);
+        int drawGroupButton(int x, int y, int index, QPainter* painter);
 
         void startDrag(int index);
         void drawDropIndicator(int index, bool disabled = false);
@@ -158,15 +216,34 @@ class TabBar : public QWidget
         bool isSameTab(const QDropEvent*);
 
         void _addGroup(const QString& title = QStringLiteral(), bool locked = false);
+        void restoreGroups(const LayoutConfig::TabsGroupsList &groups, int active_group_index, bool lazy, bool from_layout);
+        int addLayoutTab(int group_id, const LayoutConfig::Tab &tab, bool deferred);
+        void reloadGroupTabs(int group_id, const LayoutConfig::TabsGroup &group, QList<int> &obsolete_tabs);
+        void queueRealization(int sessionId);
+        void removeBackgroundTab(int sessionId);
+        void setGroupFromLayout(int group_id, bool from_layout);
+        void setLayoutTabName(int sessionId, const QString &name);
+        void resetJournal();
 
         MainWindow* m_mainWindow;
         Skin* m_skin;
+        SessionJournal* m_journal;
+
+        QFileSystemWatcher* m_layoutWatcher;
+        QTimer* m_layoutReloadTimer;
+        QDateTime m_layoutModified;
+        qint64 m_layoutSize;
+        QHash<int, QString> m_layoutTabNames;
+
+        QTimer* m_realizationTimer;
+        QList<int> m_realizationQueue;
+        QSet<int> m_pendingSessions;
 
-        QToolButton* m_newTabButton;
-        QPushButton* m_closeTabButton;
+        SkinButton* m_newTabButton;
+        SkinButton* m_closeTabButton;
 
-        QToolButton* m_newGroupButton;
-        QPushButton* m_closeGroupButton;
+        SkinButton* m_newGroupButton;
+        SkinButton* m_closeGroupButton;
 
         QMenu* m_tabContextMenu;
         QMenu* m_groupContextMenu;
@@ -179,13 +256,29 @@ class TabBar : public QWidget
         int m_renamingSessionId;
         int m_renamingIndex;
 
-        QList<TabGroup> m_groups;
-        QList<int> m_groupWidths;
+        TabModel m_model;
         int active_group;
 
-        QHash<int, QString> m_tabTitles;
         QHash<int, bool> m_tabTitlesSetInteractive;
-        QList<int> m_tabWidths;
+
+        QuickSwitchIndex m_switchIndex;
+        QuickSwitcher* m_quickSwitcher;
+
+        QVector<StripItem> m_tabItems;
+        QVector<StripItem> m_groupItems;
+        bool m_layoutDirty;
+        int m_selectedTabIndex;
+        int m_tabScroll;
+        int m_groupScroll;
+        bool m_revealSelection;
+        QFont m_font;
+        QFont m_boldFont;
+
+        QCache<QString, QPixmap> m_buttonCache;
+        int m_skinGeneration;
+
+        QRegion m_cornerClipRegion;
+        int m_cornerClipX;
 
         int m_selectedSessionId;
         bool interactiveRename4Group;
@@ -194,6 +287,7 @@ class TabBar : public QWidget
         int m_mousePressedIndex;
         bool m_mousePressed4Group;
         bool disable_groups_cfg_update;
+        bool m_restoringLayout;
 
         QPoint m_startPos;
         QLabel* m_dropIndicator;
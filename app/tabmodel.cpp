@@ -0,0 +1,177 @@
+/*
+  This program is free software; you can redistribute it and/or
+  modify it under the terms of the GNU General Public License as
+  published by the Free Software Foundation; either version 2 of
+  the License or (at your option) version 3 or any later version
+  accepted by the membership of KDE e.V. (or its successor appro-
+  ved by the membership of KDE e.V.), which shall act as a proxy
+  defined in Section 14 of version 3 of the license.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program. If not, see http://www.gnu.org/licenses/.
+*/
+
+
+#include "tabmodel.h"
+
+
+TabGroup::TabGroup(const QString &t, bool is_locked):
+    title(t), locked(is_locked), selected_tab(0), from_layout(false),
+    remove_when_empty(false)
+{}
+
+TabModel::TabModel()
+{
+}
+
+int TabModel::appendGroup(const QString& title, bool locked)
+{
+    m_groups.append(TabGroup(title, locked));
+    countTitle(m_groupTitles, title, 1);
+
+    return m_groups.count() - 1;
+}
+
+void TabModel::removeGroup(int group_id)
+{
+    if (group_id < 0 || group_id >= m_groups.count()) return;
+
+    const TabGroup& group = m_groups.at(group_id);
+
+    foreach (int sessionId, group.tabs)
+    {
+        m_positions.remove(sessionId);
+        countTitle(m_tabTitles, m_titles.take(sessionId), -1);
+    }
+
+    countTitle(m_groupTitles, group.title, -1);
+
+    m_groups.removeAt(group_id);
+
+    for (int index = group_id; index < m_groups.count(); ++index)
+        reindex(index);
+}
+
+void TabModel::swapGroups(int first, int second)
+{
+    m_groups.swap(first, second);
+
+    reindex(first);
+    reindex(second);
+}
+
+void TabModel::setGroupTitle(int group_id, const QString& title)
+{
+    countTitle(m_groupTitles, m_groups.at(group_id).title, -1);
+    countTitle(m_groupTitles, title, 1);
+
+    m_groups[group_id].title = title;
+}
+
+void TabModel::setGroupLocked(int group_id, bool locked)
+{
+    m_groups[group_id].locked = locked;
+}
+
+void TabModel::setGroupFromLayout(int group_id, bool from_layout)
+{
+    m_groups[group_id].from_layout = from_layout;
+}
+
+void TabModel::setGroupRemoveWhenEmpty(int group_id, bool remove)
+{
+    m_groups[group_id].remove_when_empty = remove;
+}
+
+void TabModel::setSelectedTab(int group_id, int index)
+{
+    m_groups[group_id].selected_tab = index;
+}
+
+void TabModel::appendTab(int group_id, int sessionId, const QString& title)
+{
+    TabGroup& group = m_groups[group_id];
+
+    group.tabs.append(sessionId);
+    m_positions.insert(sessionId, Position(group_id, group.tabs.count() - 1));
+
+    m_titles.insert(sessionId, title);
+    countTitle(m_tabTitles, title, 1);
+}
+
+int TabModel::removeTab(int sessionId)
+{
+    if (!m_positions.contains(sessionId)) return -1;
+
+    Position position = m_positions.take(sessionId);
+    TabGroup& group = m_groups[position.group];
+
+    group.tabs.removeAt(position.index);
+
+    if (group.selected_tab > 0 && group.selected_tab >= position.index)
+        group.selected_tab--;
+
+    reindex(position.group, position.index);
+
+    countTitle(m_tabTitles, m_titles.take(sessionId), -1);
+
+    return position.group;
+}
+
+void TabModel::moveTab(int sessionId, int group_id, int index)
+{
+    if (!m_positions.contains(sessionId)) return;
+
+    Position position = m_positions.value(sessionId);
+
+    m_groups[position.group].tabs.removeAt(position.index);
+
+    QList<int>& tabs = m_groups[group_id].tabs;
+    index = qBound(0, index, tabs.count());
+    tabs.insert(index, sessionId);
+
+    // Within a group only the tabs between the old and the new position shift.
+    if (position.group == group_id)
+        reindex(group_id, qMin(position.index, index), qMax(position.index, index));
+    else
+    {
+        reindex(position.group, position.index);
+        reindex(group_id, index);
+    }
+}
+
+void TabModel::setTabTitle(int sessionId, const QString& title)
+{
+    if (!m_titles.contains(sessionId)) return;
+
+    countTitle(m_tabTitles, m_titles.value(sessionId), -1);
+    countTitle(m_tabTitles, title, 1);
+
+    m_titles.insert(sessionId, title);
+}
+
+void TabModel::reindex(int group_id, int from, int to)
+{
+    const QList<int>& tabs = m_groups.at(group_id).tabs;
+
+    if (to < 0 || to >= tabs.count())
+        to = tabs.count() - 1;
+
+    for (int index = from; index <= to; ++index)
+        m_positions.insert(tabs.at(index), Position(group_id, index));
+}
+
+void TabModel::countTitle(QHash<QString, int>& counts, const QString& title, int delta)
+{
+    int count = counts.value(title) + delta;
+
+    if (count > 0)
+        counts.insert(title, count);
+    else
+        counts.remove(title);
+}
@@ -0,0 +1,98 @@
+/*
+  This program is free software; you can redistribute it and/or
+  modify it under the terms of the GNU General Public License as
+  published by the Free Software Foundation; either version 2 of
+  the License or (at your option) version 3 or any later version
+  accepted by the membership of KDE e.V. (or its successor appro-
+  ved by the membership of KDE e.V.), which shall act as a proxy
+  defined in Section 14 of version 3 of the license.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program. If not, see http://www.gnu.org/licenses/.
+*/
+
+
+#ifndef TABMODEL_H
+#define TABMODEL_H
+
+
+#include <QHash>
+#include <QList>
+#include <QString>
+
+
+struct TabGroup {
+    QList<int> tabs;
+    QString title;
+    bool locked;
+    int selected_tab;
+    bool from_layout;
+    //dropped from the layout file with all its tabs; goes away with its last tab even when locked
+    bool remove_when_empty;
+    TabGroup(const QString &t, bool is_locked = false);
+};
+
+class TabModel
+{
+    public:
+        TabModel();
+
+        int groupCount() const { return m_groups.count(); }
+        bool isEmpty() const { return m_groups.isEmpty(); }
+        const QList<TabGroup>& groups() const { return m_groups; }
+        const TabGroup& group(int group_id) const { return m_groups.at(group_id); }
+        const QList<int>& tabs(int group_id) const { return m_groups.at(group_id).tabs; }
+
+        int appendGroup(const QString& title, bool locked);
+        void removeGroup(int group_id);
+        void swapGroups(int first, int second);
+        void setGroupTitle(int group_id, const QString& title);
+        void setGroupLocked(int group_id, bool locked);
+        void setGroupFromLayout(int group_id, bool from_layout);
+        void setGroupRemoveWhenEmpty(int group_id, bool remove);
+        void setSelectedTab(int group_id, int index);
+        bool hasGroupTitle(const QString& title) const { return m_groupTitles.value(title) > 0; }
+
+        void appendTab(int group_id, int sessionId, const QString& title);
+        int removeTab(int sessionId);
+        void moveTab(int sessionId, int group_id, int index);
+
+        bool contains(int sessionId) const { return m_positions.contains(sessionId); }
+        int groupOf(int sessionId) const { return m_positions.value(sessionId).group; }
+        int indexOf(int sessionId) const { return m_positions.value(sessionId).index; }
+
+        QString tabTitle(int sessionId) const { return m_titles.value(sessionId); }
+        void setTabTitle(int sessionId, const QString& title);
+        bool hasTabTitle(const QString& title) const { return m_tabTitles.value(title) > 0; }
+
+
+    private:
+        struct Position
+        {
+            Position() : group(-1), index(-1) {}
+            Position(int g, int i) : group(g), index(i) {}
+
+            int group;
+            int index;
+        };
+
+        // Rewrites the positions of the tabs in [from, to], or up to the end of the group.
+        void reindex(int group_id, int from = 0, int to = -1);
+        void countTitle(QHash<QString, int>& counts, const QString& title, int delta);
+
+        QList<TabGroup> m_groups;
+
+        QHash<int, Position> m_positions;
+        QHash<int, QString> m_titles;
+
+        // How many tabs and groups use each title, for picking unused standard titles.
+        QHash<QString, int> m_tabTitles;
+        QHash<QString, int> m_groupTitles;
+};
+
+#endif
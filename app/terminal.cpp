@@ -20,6 +20,7 @@
 
 
 #include "terminal.h"
+#include "metrics.h"
 #include "settings.h"
 
 #include <KActionCollection>
@@ -29,10 +30,12 @@
 #include <KPluginFactory>
 #include <KPluginLoader>
 #include <KService>
+#include <KSycoca>
 #include <KUser>
 
 #include <QAction>
 #include <QApplication>
+#include <QElapsedTimer>
 #include <QHBoxLayout>
 #include <QLabel>
 #include <QWidget>
@@ -42,6 +45,32 @@
 
 int Terminal::m_availableTerminalId = 0;
 
+QPointer<KPluginFactory> Terminal::m_partFactory;
+
+KPluginFactory* Terminal::partFactory()
+{
+    static bool watchingSycoca = false;
+
+    if (!watchingSycoca)
+    {
+        // Resolve the part again next time if the service database changes, e.g. after a Konsole upgrade.
+        connect(KSycoca::self(), static_cast<void (KSycoca::*)(const QStringList&)>(&KSycoca::databaseChanged),
+            [](const QStringList&) { m_partFactory.clear(); });
+
+        watchingSycoca = true;
+    }
+
+    if (!m_partFactory)
+    {
+        KService::Ptr service = KService::serviceByDesktopName(QStringLiteral("konsolepart"));
+
+        if (service)
+            m_partFactory = KPluginLoader(service->library()).factory();
+    }
+
+    return m_partFactory;
+}
+
 Terminal::Terminal(QWidget* parent) : QObject(parent)
 {
     m_terminalId = m_availableTerminalId;
@@ -58,12 +87,12 @@ Terminal::Terminal(QWidget* parent) : QObject(parent)
     m_terminalWidget = NULL;
     m_parentSplitter = parent;
 
-    KPluginFactory* factory = 0;
-    KService::Ptr service = KService::serviceByDesktopName(QStringLiteral("konsolepart"));
-    if( service )
-    {
-        factory = KPluginLoader(service->library()).factory();
-    }
+    qint64 constructionStart = Metrics::self()->elapsed();
+
+    QElapsedTimer partCreationTimer;
+    partCreationTimer.start();
+
+    KPluginFactory* factory = partFactory();
 
     m_part = factory ? (factory->create<KParts::Part>(parent)) : 0;
 
@@ -87,13 +116,20 @@ Terminal::Terminal(QWidget* parent) : QObject(parent)
 
         m_terminalInterface = qobject_cast<TerminalInterface*>(m_part);
         if (m_terminalInterface) m_terminalInterface->showShellInDir(KUser().homeDir());
+
+        Metrics::self()->recordPartCreation(m_terminalId, partCreationTimer.nsecsElapsed());
     }
     else
         displayKPartLoadError();
+
+    if (Metrics::self()->isStartingUp())
+        Metrics::self()->addStartupPhase(QStringLiteral("Terminal %1").arg(m_terminalId), constructionStart);
 }
 
 Terminal::~Terminal()
 {
+    Metrics::self()->removeTerminal(m_terminalId);
+
     emit destroyed(m_terminalId);
 }
 
@@ -105,6 +141,21 @@ void Terminal::deletePart()
         deleteLater();
 }
 
+void Terminal::reparent(QWidget* splitter)
+{
+    setParent(splitter);
+
+    if (m_part) m_part->setParent(splitter);
+
+    m_parentSplitter = splitter;
+
+    if (m_partWidget)
+    {
+        m_partWidget->setParent(splitter);
+        m_partWidget->show();
+    }
+}
+
 bool Terminal::eventFilter(QObject* /* watched */, QEvent* event)
 {
     if (event->type() == QEvent::FocusIn)
@@ -223,6 +274,8 @@ void Terminal::disableOffendingPartActions()
 
 void Terminal::setTitle(const QString& title)
 {
+    if (title == m_title) return;
+
     m_title = title;
 
     emit titleChanged(m_terminalId, m_title);
@@ -233,6 +286,28 @@ void Terminal::runCommand(const QString& command)
     m_terminalInterface->sendInput(command + QStringLiteral("\n"));
 }
 
+int Terminal::foregroundProcessId()
+{
+    if (!m_terminalInterface) return -1;
+
+    return m_terminalInterface->foregroundProcessId();
+}
+
+QString Terminal::foregroundProcessName()
+{
+    if (!m_terminalInterface || m_terminalInterface->foregroundProcessId() <= 0) return QString();
+
+    return m_terminalInterface->foregroundProcessName();
+}
+
+bool Terminal::isShellReady()
+{
+    if (!m_terminalInterface) return false;
+
+    // The part reports no foreground process while the shell itself owns the terminal.
+    return m_terminalInterface->terminalProcessId() > 0 && m_terminalInterface->foregroundProcessId() <= 0;
+}
+
 void Terminal::manageProfiles()
 {
     QMetaObject::invokeMethod(m_part, "showManageProfilesDialog",
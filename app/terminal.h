@@ -29,6 +29,7 @@
 
 class QKeyEvent;
 
+class KPluginFactory;
 class TerminalInterface;
 
 
@@ -50,9 +51,16 @@ class Terminal : public QObject
 
         QWidget* splitter() { return m_parentSplitter; }
         void setSplitter(QWidget* splitter) { m_parentSplitter = splitter; }
+        void reparent(QWidget* splitter);
+
+        bool hasPart() { return m_part; }
 
         void runCommand(const QString& command);
 
+        int foregroundProcessId();
+        QString foregroundProcessName();
+        bool isShellReady();
+
         void manageProfiles();
         void editProfile();
 
@@ -86,6 +94,8 @@ class Terminal : public QObject
 
 
     private:
+        static KPluginFactory* partFactory();
+
         void disableOffendingPartActions();
 
         void displayKPartLoadError();
@@ -93,6 +103,8 @@ class Terminal : public QObject
         static int m_availableTerminalId;
         int m_terminalId;
 
+        static QPointer<KPluginFactory> m_partFactory;
+
         KParts::Part* m_part;
         TerminalInterface* m_terminalInterface;
         QWidget* m_partWidget;
@@ -0,0 +1,120 @@
+/*
+  This program is free software; you can redistribute it and/or
+  modify it under the terms of the GNU General Public License as
+  published by the Free Software Foundation; either version 2 of
+  the License or (at your option) version 3 or any later version
+  accepted by the membership of KDE e.V. (or its successor appro-
+  ved by the membership of KDE e.V.), which shall act as a proxy
+  defined in Section 14 of version 3 of the license.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program. If not, see http://www.gnu.org/licenses/.
+*/
+
+
+#include "terminalpool.h"
+#include "metrics.h"
+#include "settings.h"
+#include "terminal.h"
+
+#include <QTimer>
+#include <QWidget>
+
+
+TerminalPool::TerminalPool(QWidget* parent) : QObject(parent)
+{
+    // Spare terminals live in a hidden widget until a session takes them.
+    m_holder = new QWidget(parent);
+    m_holder->hide();
+
+    m_refillTimer = new QTimer(this);
+    m_refillTimer->setSingleShot(true);
+    connect(m_refillTimer, SIGNAL(timeout()), this, SLOT(refill()));
+}
+
+TerminalPool::~TerminalPool()
+{
+}
+
+Terminal* TerminalPool::takeTerminal(QWidget* parent)
+{
+    if (Settings::terminalPoolSize() <= 0) return 0;
+
+    Terminal* terminal = 0;
+
+    while (!terminal && !m_terminals.isEmpty())
+    {
+        terminal = m_terminals.takeFirst();
+
+        // Skip spares whose shell has exited while they were waiting.
+        if (terminal && !terminal->terminalWidget())
+        {
+            disconnect(terminal, 0, this, 0);
+            terminal = 0;
+        }
+    }
+
+    scheduleRefill();
+
+    if (!terminal)
+    {
+        Metrics::self()->recordTerminalPoolMiss();
+
+        return 0;
+    }
+
+    disconnect(terminal, 0, this, 0);
+    terminal->reparent(parent);
+
+    Metrics::self()->recordTerminalPoolHit();
+    Metrics::self()->recordSpareTaken(terminal->id());
+
+    return terminal;
+}
+
+void TerminalPool::scheduleRefill()
+{
+    if (!m_refillTimer->isActive())
+        m_refillTimer->start(Settings::terminalPoolRefillDelay());
+}
+
+void TerminalPool::refill()
+{
+    m_terminals.removeAll(QPointer<Terminal>());
+
+    int size = Settings::terminalPoolSize();
+
+    while (m_terminals.count() > size)
+    {
+        Terminal* terminal = m_terminals.takeLast();
+
+        disconnect(terminal, 0, this, 0);
+        terminal->deletePart();
+    }
+
+    if (m_terminals.count() >= size) return;
+
+    Terminal* terminal = new Terminal(m_holder);
+
+    if (!terminal->hasPart())
+    {
+        // The part failed to load; don't keep retrying in the background.
+        terminal->deletePart();
+
+        return;
+    }
+
+    connect(terminal, SIGNAL(destroyed(int)), this, SLOT(scheduleRefill()));
+    m_terminals.append(terminal);
+
+    Metrics::self()->recordSparePart(terminal->id());
+
+    // Build the remaining spares one per event loop turn.
+    if (m_terminals.count() < size)
+        m_refillTimer->start(0);
+}
@@ -22,10 +22,10 @@
 #include "titlebar.h"
 #include "mainwindow.h"
 #include "skin.h"
+#include "skinbutton.h"
 
 #include <QFontDatabase>
 #include <QMenu>
-#include <QPushButton>
 #include <KLocalizedString>
 
 #include <QApplication>
@@ -44,21 +44,19 @@ TitleBar::TitleBar(MainWindow* mainWindow) : QWidget(mainWindow)
     m_mainWindow = mainWindow;
     m_skin = mainWindow->skin();
 
-    m_focusButton = new QPushButton(this);
-    m_focusButton->setFocusPolicy(Qt::NoFocus);
+    m_focusButton = new SkinButton(this);
     m_focusButton->setCheckable(true);
     m_focusButton->setToolTip(xi18nc("@info:tooltip", "Keep window open when it loses focus"));
     m_focusButton->setWhatsThis(xi18nc("@info:whatsthis", "If this is checked, the window will stay open when it loses focus."));
     connect(m_focusButton, SIGNAL(toggled(bool)), mainWindow, SLOT(setKeepOpen(bool)));
 
-    m_menuButton = new QPushButton(this);
-    m_menuButton->setFocusPolicy(Qt::NoFocus);
+    m_menuButton = new SkinButton(this);
     m_menuButton->setMenu(mainWindow->menu());
+    m_menuButton->setPopupMode(QToolButton::InstantPopup);
     m_menuButton->setToolTip(xi18nc("@info:tooltip", "Open Menu"));
     m_menuButton->setWhatsThis(xi18nc("@info:whatsthis", "Opens the main menu."));
 
-    m_quitButton = new QPushButton(this);
-    m_quitButton->setFocusPolicy(Qt::NoFocus);
+    m_quitButton = new SkinButton(this);
     m_quitButton->setToolTip(xi18nc("@info:tooltip Quits the application", "Quit"));
     m_quitButton->setWhatsThis(xi18nc("@info:whatsthis", "Quits the application."));
     connect(m_quitButton, SIGNAL(clicked()), qApp, SLOT(quit()));
@@ -70,11 +68,16 @@ TitleBar::~TitleBar()
 
 void TitleBar::applySkin()
 {
-    resize(width(), m_skin->titleBarBackgroundImage().height());
+    resize(width(), Skin::imageSize(m_skin->titleBarBackgroundImage()).height());
 
-    m_focusButton->setStyleSheet(m_skin->titleBarFocusButtonStyleSheet());
-    m_menuButton->setStyleSheet(m_skin->titleBarMenuButtonStyleSheet());
-    m_quitButton->setStyleSheet(m_skin->titleBarQuitButtonStyleSheet());
+    const Skin::ButtonImages& focusImages = m_skin->titleBarFocusButtonImages();
+    m_focusButton->setImages(focusImages.up, focusImages.over, focusImages.down);
+
+    const Skin::ButtonImages& menuImages = m_skin->titleBarMenuButtonImages();
+    m_menuButton->setImages(menuImages.up, menuImages.over, menuImages.down);
+
+    const Skin::ButtonImages& quitImages = m_skin->titleBarQuitButtonImages();
+    m_quitButton->setImages(quitImages.up, quitImages.over, quitImages.down);
 
     m_focusButton->move(width() - m_skin->titleBarFocusButtonPosition().x(), m_skin->titleBarFocusButtonPosition().y());
     m_menuButton->move(width() - m_skin->titleBarMenuButtonPosition().x(), m_skin->titleBarMenuButtonPosition().y());
@@ -101,16 +104,7 @@ void TitleBar::paintEvent(QPaintEvent*)
     QPainter painter(this);
     painter.setPen(m_skin->titleBarTextColor());
 
-    const QPixmap& backgroundImage = m_skin->titleBarBackgroundImage();
-    const QPixmap& leftCornerImage = m_skin->titleBarLeftCornerImage();
-    const QPixmap& rightCornerImage = m_skin->titleBarRightCornerImage();
-
-    painter.drawTiledPixmap(leftCornerImage.width(), 0,
-                            width() - leftCornerImage.width() - rightCornerImage.width(), height(),
-                            backgroundImage);
-
-    painter.drawPixmap(0, 0, leftCornerImage);
-    painter.drawPixmap(width() - rightCornerImage.width(), 0, rightCornerImage);
+    painter.drawPixmap(0, 0, m_skin->titleBarPixmap(width()));
 
     QFont font = QFontDatabase::systemFont(QFontDatabase::TitleFont);
     font.setBold(m_skin->titleBarTextBold());
@@ -123,20 +117,7 @@ void TitleBar::paintEvent(QPaintEvent*)
 
 void TitleBar::updateMask()
 {
-    const QPixmap& leftCornerImage = m_skin->titleBarLeftCornerImage();
-    const QPixmap& rightCornerImage = m_skin->titleBarRightCornerImage();
-
-    QRegion leftCornerRegion = leftCornerImage.hasAlpha() ? QRegion(leftCornerImage.mask()) : QRegion(leftCornerImage.rect());
-    QRegion rightCornerRegion = rightCornerImage.hasAlpha() ? QRegion(rightCornerImage.mask()) : QRegion(rightCornerImage.rect());
-
-    QRegion mask = leftCornerRegion;
-
-    mask += QRegion(QRect(0, 0, width() - leftCornerImage.width() - rightCornerImage.width(),
-        height())).translated(leftCornerImage.width(), 0);
-
-    mask += rightCornerRegion.translated(width() - rightCornerImage.width(), 0);
-
-    setMask(mask);
+    setMask(m_skin->titleBarMask(width()));
 }
 
 void TitleBar::setFocusButtonState(bool checked)
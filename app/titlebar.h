@@ -28,8 +28,7 @@
 
 class MainWindow;
 class Skin;
-
-class QPushButton;
+class SkinButton;
 
 
 class TitleBar : public QWidget
@@ -61,9 +60,9 @@ class TitleBar : public QWidget
         MainWindow* m_mainWindow;
         Skin* m_skin;
 
-        QPushButton* m_focusButton;
-        QPushButton* m_menuButton;
-        QPushButton* m_quitButton;
+        SkinButton* m_focusButton;
+        SkinButton* m_menuButton;
+        SkinButton* m_quitButton;
 
         QString m_title;
 };
@@ -0,0 +1,78 @@
+/*
+  This program is free software; you can redistribute it and/or
+  modify it under the terms of the GNU General Public License as
+  published by the Free Software Foundation; either version 2 of
+  the License or (at your option) version 3 or any later version
+  accepted by the membership of KDE e.V. (or its successor appro-
+  ved by the membership of KDE e.V.), which shall act as a proxy
+  defined in Section 14 of version 3 of the license.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program. If not, see http://www.gnu.org/licenses/.
+*/
+
+
+#include "titlecoalescer.h"
+
+#include <QTimer>
+
+
+// Titles are passed on at most once per frame, however often the shell rewrites them.
+static const int flushInterval = 16;
+
+TitleCoalescer::TitleCoalescer(QObject* parent) : QObject(parent)
+{
+    m_flushTimer = new QTimer(this);
+    m_flushTimer->setSingleShot(true);
+    m_flushTimer->setInterval(flushInterval);
+    connect(m_flushTimer, SIGNAL(timeout()), this, SLOT(flush()));
+}
+
+TitleCoalescer::~TitleCoalescer()
+{
+}
+
+void TitleCoalescer::remove(int sessionId)
+{
+    m_pending.remove(sessionId);
+    m_current.remove(sessionId);
+}
+
+void TitleCoalescer::setTitle(int sessionId, const QString& title)
+{
+    // A title that goes back to what was last passed on cancels the pending update.
+    if (m_current.contains(sessionId) && m_current.value(sessionId) == title)
+    {
+        m_pending.remove(sessionId);
+        return;
+    }
+
+    m_pending.insert(sessionId, title);
+
+    if (!m_flushTimer->isActive())
+        m_flushTimer->start();
+}
+
+void TitleCoalescer::flush()
+{
+    m_flushTimer->stop();
+
+    QHash<int, QString> pending;
+    pending.swap(m_pending);
+
+    QHashIterator<int, QString> it(pending);
+
+    while (it.hasNext())
+    {
+        it.next();
+
+        m_current.insert(it.key(), it.value());
+
+        emit titleChanged(it.key(), it.value());
+    }
+}
@@ -0,0 +1,59 @@
+/*
+  This program is free software; you can redistribute it and/or
+  modify it under the terms of the GNU General Public License as
+  published by the Free Software Foundation; either version 2 of
+  the License or (at your option) version 3 or any later version
+  accepted by the membership of KDE e.V. (or its successor appro-
+  ved by the membership of KDE e.V.), which shall act as a proxy
+  defined in Section 14 of version 3 of the license.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program. If not, see http://www.gnu.org/licenses/.
+*/
+
+
+#ifndef TITLECOALESCER_H
+#define TITLECOALESCER_H
+
+
+#include <QHash>
+#include <QObject>
+
+
+class QTimer;
+
+
+class TitleCoalescer : public QObject
+{
+    Q_OBJECT
+
+    public:
+        explicit TitleCoalescer(QObject* parent = 0);
+         ~TitleCoalescer();
+
+        void remove(int sessionId);
+
+
+    public Q_SLOTS:
+        void setTitle(int sessionId, const QString& title);
+
+        void flush();
+
+
+    Q_SIGNALS:
+        void titleChanged(int sessionId, const QString& title);
+
+
+    private:
+        QHash<int, QString> m_pending;
+        QHash<int, QString> m_current;
+
+        QTimer* m_flushTimer;
+};
+
+#endif